@@ -6,6 +6,7 @@
 
 #include <vsgGIS/gdal_utils.h>
 #include <vsgGIS/meta_utils.h>
+#include <vsgGIS/raster_utils.h>
 
 int main(int argc, char** argv)
 {
@@ -13,9 +14,16 @@ int main(int argc, char** argv)
 
     vsg::CommandLine arguments(&argc, argv);
 
+    // optional conversion of single band float/integer datasets such as DEMs to 16bit storage
+    bool halfFloat = arguments.read("--half-float");
+    bool unorm16 = arguments.read("--unorm16");
+
+    // skip writing outputs that only contain NoData
+    bool sparse = arguments.read("--sparse");
+
     if (argc < 3)
     {
-        vsg::info("usage:\n    vsggis input.tif [input.tif] [input.tif] [inputfile.tif] output.vsgt");
+        vsg::info("usage:\n    vsggis [--half-float] [--unorm16] [--sparse] input.tif [input.tif] [input.tif] [inputfile.tif] output.vsgt");
         return 1;
     }
 
@@ -95,9 +103,47 @@ int main(int argc, char** argv)
 
     auto image = vsgGIS::createImage2D(width, height, numComponents, dataType, vsg::dvec4(0.0, 0.0, 0.0, 1.0));
 
+    vsgGIS::RasterCoverage coverage;
     for (int component = 0; component < static_cast<int>(rasterBands.size()); ++component)
     {
-        vsgGIS::copyRasterBandToImage(*rasterBands[component], *image, component);
+        vsgGIS::RasterCoverage bandCoverage;
+        if (!vsgGIS::copyRasterBandToImage(*rasterBands[component], *image, component, &bandCoverage))
+        {
+            vsg::info("Failed to read raster band ", component + 1, ", no output written.");
+            return 1;
+        }
+        coverage.merge(bandCoverage);
+    }
+
+    vsg::info("blocks empty = ", coverage.count(vsgGIS::BLOCK_EMPTY), ", partial = ", coverage.count(vsgGIS::BLOCK_PARTIAL), ", full = ", coverage.count(vsgGIS::BLOCK_FULL));
+
+    if (sparse && coverage.empty())
+    {
+        vsg::info("All blocks are NoData, no output written.");
+        return 0;
+    }
+
+    if (halfFloat || unorm16)
+    {
+        if (numComponents == 1)
+        {
+            int hasNoData = FALSE;
+            double noData = rasterBands[0]->GetNoDataValue(&hasNoData);
+            const double* noDataValue = hasNoData ? &noData : nullptr;
+
+            auto range = vsgGIS::computeValueRange(*image, 0, noDataValue);
+            vsg::info("value range ", range.minimum, " to ", range.maximum);
+
+            auto converted = unorm16 ? vsgGIS::quantizeToUNorm16(*image, range, 0, noDataValue) : vsgGIS::convertToHalfFloat(*image, 0, range.valid() ? range.minimum : 0.0, noDataValue);
+            if (converted)
+                image = converted;
+            else
+                vsg::info("Unable to convert data to 16bit storage, writing original data type.");
+        }
+        else
+        {
+            vsg::info("--half-float and --unorm16 are only supported for single band datasets.");
+        }
     }
 
     if (main_dataset->GetProjectionRef())
@@ -111,6 +157,12 @@ int main(int argc, char** argv)
         image->setObject("GeoTransform", transform);
     }
 
+    if (coverage.count(vsgGIS::BLOCK_EMPTY) > 0)
+    {
+        image->setObject("BlockCoverage", coverage.createData());
+        if (coverage.empty()) vsgGIS::setNoDataOnly(*image, true);
+    }
+
     vsgGIS::assignMetaData(*main_dataset, *image);
 
     vsg::Path output_filename = arguments[argc - 1];
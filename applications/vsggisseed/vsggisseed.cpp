@@ -0,0 +1,92 @@
+#include <vsg/all.h>
+
+#ifdef vsgXchange_FOUND
+#    include <vsgXchange/all.h>
+#endif
+
+#include <fstream>
+
+#include <vsgGIS/TileSeeder.h>
+
+int main(int argc, char** argv)
+{
+    vsg::CommandLine arguments(&argc, argv);
+
+    // region to seed, either a latitude, longitude bounding box or a file of latitude longitude polygon vertices, one per line
+    double minLatitude = 0.0, minLongitude = 0.0, maxLatitude = 0.0, maxLongitude = 0.0;
+    bool hasBoundingBox = arguments.read("--bbox", minLatitude, minLongitude, maxLatitude, maxLongitude);
+    auto polygonFilename = arguments.value<std::string>("", "--polygon");
+
+    uint32_t minLevel = 0, maxLevel = 10;
+    arguments.read("--levels", minLevel, maxLevel);
+
+    // layer to seed, defaults to the imageLayer
+    bool terrain = arguments.read("--terrain");
+
+    auto numThreads = arguments.value<uint32_t>(0, "--threads");
+
+    if (argc != 3 || (!hasBoundingBox && polygonFilename.empty()))
+    {
+        vsg::info("usage:\n    vsggisseed [--bbox minLat minLon maxLat maxLon] [--polygon polygon.txt] [--levels min max] [--terrain] [--threads n] settings.vsgt output.vsgtiles|output_directory");
+        return 1;
+    }
+
+    auto options = vsg::Options::create();
+    options->paths = vsg::getEnvPaths("VSG_FILE_PATH");
+#ifdef vsgXchange_FOUND
+    options->add(vsgXchange::all::create());
+#endif
+
+    auto settings = vsg::read_cast<vsgGIS::TileDatabaseSettings>(arguments[1], options);
+    if (!settings)
+    {
+        vsg::info("Unable to read TileDatabaseSettings from ", arguments[1]);
+        return 1;
+    }
+
+    vsg::Path layer = terrain ? settings->terrainLayer : settings->imageLayer;
+    if (layer.empty())
+    {
+        vsg::info("No ", terrain ? "terrainLayer" : "imageLayer", " to seed.");
+        return 1;
+    }
+
+#ifndef vsgXchange_FOUND
+    // without vsgXchange only the native formats can be read, so fail up front rather than on every tile
+    auto extension = vsg::lowerCaseFileExtension(layer);
+    if (extension != ".vsgb" && extension != ".vsgt")
+    {
+        vsg::info("vsggisseed was built without vsgXchange so can only read .vsgb and .vsgt tiles, unable to seed ", layer);
+        return 1;
+    }
+#endif
+
+    auto seeder = vsgGIS::TileSeeder::create(settings);
+    seeder->numThreads = numThreads;
+    seeder->progressCallback = [](const vsgGIS::TileSeeder::Progress& progress) {
+        vsg::info("seeded ", progress.numCompleted, " of ", progress.numTiles, " tiles, failed ", progress.numFailed, ", ", progress.tilesPerSecond(), " tiles/s, ", progress.bytesPerSecond() / (1024.0 * 1024.0), " MB/s");
+    };
+
+    std::vector<uint64_t> tiles;
+    if (!polygonFilename.empty())
+    {
+        std::vector<vsg::dvec2> polygon;
+        std::ifstream fin(polygonFilename);
+        double latitude, longitude;
+        while (fin >> latitude >> longitude) polygon.emplace_back(latitude, longitude);
+
+        tiles = seeder->computeTiles(polygon, minLevel, maxLevel);
+    }
+    else
+    {
+        tiles = seeder->computeTiles(minLatitude, minLongitude, maxLatitude, maxLongitude, minLevel, maxLevel);
+    }
+
+    vsg::info("seeding ", tiles.size(), " tiles of ", layer, " between levels ", minLevel, " and ", maxLevel);
+
+    auto progress = seeder->seed(tiles, layer, arguments[2], options);
+
+    vsg::info("Written ", progress.numCompleted - progress.numFailed, " tiles to ", arguments[2], " in ", progress.elapsedTime, " seconds.");
+
+    return progress.numFailed > 0 ? 1 : 0;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsgGIS/Export.h>
+
+#include <vsg/core/Array.h>
+#include <vsg/io/Path.h>
+
+#include <mutex>
+#include <vector>
+
+namespace vsgGIS
+{
+
+    /// AsyncFileReader reads batches of whole local files into memory. On Linux, when built with liburing, all the reads of a batch are submitted together through io_uring
+    /// so a single thread keeps many reads in flight, otherwise the files are read one after another with pread().
+    class VSGGIS_DECLSPEC AsyncFileReader : public vsg::Inherit<vsg::Object, AsyncFileReader>
+    {
+    public:
+        /// queueDepth is the maximum number of reads in flight per batch.
+        explicit AsyncFileReader(uint32_t in_queueDepth = 64);
+
+        AsyncFileReader(const AsyncFileReader&) = delete;
+        AsyncFileReader& operator=(const AsyncFileReader&) = delete;
+
+        const uint32_t queueDepth;
+
+        /// return true if reads are submitted through io_uring, false if falling back to pread().
+        bool usingIOUring() const { return _usingIOUring; }
+
+        /// read the contents of each of the files, the returned vector matches the order of filenames with a null ref_ptr<> for files that couldn't be read.
+        /// Can be called from multiple threads, each call uses it's own submission queue.
+        std::vector<vsg::ref_ptr<vsg::ubyteArray>> read(const vsg::Paths& filenames);
+
+    protected:
+        virtual ~AsyncFileReader();
+
+        struct Ring;
+
+        Ring* _acquireRing();
+        void _releaseRing(Ring* ring);
+
+        bool _usingIOUring = false;
+
+        std::mutex _mutex;
+        std::vector<Ring*> _availableRings;
+    };
+
+} // namespace vsgGIS
+
+EVSG_type_name(vsgGIS::AsyncFileReader);
@@ -0,0 +1,107 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsgGIS/gdal_utils.h>
+
+#include <vsg/core/Inherit.h>
+#include <vsg/core/Object.h>
+
+#include <list>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace vsgGIS
+{
+
+    /// DatasetPool hands out GDALDataset handles dedicated to the calling thread, so that multi-threaded loaders can read from the same files concurrently without reopening them for each read.
+    /// The number of open datasets is bounded, with the least recently used handles closed when the limit is exceeded. Handles still held by callers are closed once they release them.
+    class VSGGIS_DECLSPEC DatasetPool : public vsg::Inherit<vsg::Object, DatasetPool>
+    {
+    public:
+        explicit DatasetPool(size_t maxOpenDatasets = 256);
+
+        /// return a GDALDataset handle for filename that is only used by the calling thread, reusing a previously opened handle when available. Return an empty shared_ptr if the file can't be opened.
+        std::shared_ptr<GDALDataset> acquire(const vsg::Path& filename, GDALAccess access = GA_ReadOnly);
+
+        /// set the maximum number of datasets kept open, closing least recently used handles if required.
+        void setMaxOpenDatasets(size_t maxOpenDatasets);
+        size_t getMaxOpenDatasets() const;
+
+        /// close all the handles held by the pool.
+        void clear();
+
+        struct Stats
+        {
+            uint64_t numOpened = 0;  // number of datasets opened
+            uint64_t numReused = 0;  // number of acquire() calls that reused an open handle
+            uint64_t numEvicted = 0; // number of handles closed to keep within the maximum number of open datasets
+            uint64_t numFailed = 0;  // number of datasets that failed to open
+            size_t numOpen = 0;      // number of handles currently held by the pool
+        };
+
+        /// return a snapshot of the pool statistics.
+        Stats getStats() const;
+
+        /// shared pool used by vsgGIS loaders by default.
+        static vsg::ref_ptr<DatasetPool>& instance();
+
+    protected:
+        struct Key
+        {
+            std::string filename;
+            std::thread::id threadId;
+            GDALAccess access;
+
+            bool operator<(const Key& rhs) const
+            {
+                if (filename < rhs.filename) return true;
+                if (rhs.filename < filename) return false;
+                if (threadId < rhs.threadId) return true;
+                if (rhs.threadId < threadId) return false;
+                return access < rhs.access;
+            }
+        };
+
+        using LRUList = std::list<Key>;
+
+        struct Entry
+        {
+            std::shared_ptr<GDALDataset> dataset;
+            LRUList::iterator lruPosition;
+        };
+
+        void _evict();
+
+        mutable std::mutex _mutex;
+        size_t _maxOpenDatasets;
+        std::map<Key, Entry> _entries;
+        LRUList _lru; // most recently used at the front
+        Stats _stats;
+    };
+
+} // namespace vsgGIS
+
+EVSG_type_name(vsgGIS::DatasetPool);
@@ -0,0 +1,96 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsgGIS/Export.h>
+
+#include <vsg/core/Array2D.h>
+#include <vsg/core/observer_ptr.h>
+#include <vsg/maths/box.h>
+#include <vsg/nodes/Node.h>
+
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace vsgGIS
+{
+
+    class TileDatabaseSettings;
+
+    /// ElevationIndex holds the height data of the resident terrain tiles of a TileDatabase, keyed like the tile hierarchy with tileKey(x, y, level),
+    /// so that terrain height and normal at a latitude, longitude can be looked up directly rather than intersecting the tile meshes.
+    /// Tiles are added by the TileReader as they are loaded, and are dropped once their scene graph nodes have been deleted by the DatabasePager.
+    class VSGGIS_DECLSPEC ElevationIndex : public vsg::Inherit<vsg::Object, ElevationIndex>
+    {
+    public:
+        explicit ElevationIndex(vsg::ref_ptr<TileDatabaseSettings> in_settings);
+
+        struct Result
+        {
+            vsg::dvec3 position; // ECEF position of the terrain surface
+            vsg::dvec3 normal;   // ECEF unit normal of the terrain surface
+            double height = 0.0; // height above the ellipsoid
+            uint32_t level = 0;  // level of the tile the height was sampled from
+            bool valid = false;  // false if no resident tile covers the point, in which case the height is 0 and the normal is the ellipsoid up vector
+        };
+
+        /// add the heights of a tile, sampled on a regular grid over the tile extents with row 0 at the minimum y. The tile node is observed so the entry expires when the node is deleted.
+        void add(uint32_t x, uint32_t y, uint32_t level, vsg::ref_ptr<const vsg::floatArray2D> heights, vsg::Node* tile);
+
+        /// remove the entries whose tile nodes have been deleted.
+        void prune();
+
+        /// return the height and normal at latitude, longitude from the highest resolution resident tile. When deeper tiles aren't loaded yet the coarser resident tile above them is used, as indicated by Result::level.
+        Result query(double latitude, double longitude) const;
+
+        /// batched version of query(..) for the latitude, longitude of count points, writing a Result for each.
+        void query(size_t count, const vsg::dvec2* latitudeLongitudes, Result* results) const;
+
+        size_t size() const;
+
+    protected:
+        virtual ~ElevationIndex();
+
+        struct Tile
+        {
+            vsg::ref_ptr<const vsg::floatArray2D> heights;
+            vsg::dbox extents;
+            vsg::observer_ptr<vsg::Node> node;
+        };
+
+        void _prune();
+        Result _query(double latitude, double longitude) const;
+        double _sample(const Tile& tile, double x, double y) const;
+
+        vsg::ref_ptr<TileDatabaseSettings> _settings;
+
+        mutable std::shared_mutex _mutex;
+        std::unordered_map<uint64_t, Tile> _tiles;
+        uint32_t _maxLevel = 0;
+        uint32_t _numAddedSincePrune = 0;
+    };
+
+} // namespace vsgGIS
+
+EVSG_type_name(vsgGIS::ElevationIndex);
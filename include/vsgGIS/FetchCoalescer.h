@@ -0,0 +1,111 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsgGIS/AsyncFileReader.h>
+
+#include <vsg/io/Options.h>
+#include <vsg/io/read.h>
+#include <vsg/threading/OperationThreads.h>
+
+#include <atomic>
+#include <future>
+#include <list>
+#include <map>
+#include <mutex>
+#include <utility>
+
+namespace vsgGIS
+{
+
+    /// FetchCoalescer reads files for TileReader so that concurrent requests for the same path, from the same or different TileDatabase, share a single in-flight vsg::read(..)
+    /// and it's decoded result, rather than each reading and decoding the file. Optionally the most recently read vsg::Data are kept in a LRU cache so re-requests are served from memory.
+    /// Requests are keyed by the file that vsg::findFile(..) resolves the path to, or when the path doesn't resolve to a local file by the path and the Options it's read with,
+    /// so requests from databases with different Options are only shared when they resolve to the same file.
+    class VSGGIS_DECLSPEC FetchCoalescer : public vsg::Inherit<vsg::Object, FetchCoalescer>
+    {
+    public:
+        FetchCoalescer();
+
+        /// process wide FetchCoalescer that TileReader uses by default.
+        static vsg::ref_ptr<FetchCoalescer>& instance();
+
+        /// maximum size in bytes of the vsg::Data kept in the cache of recently read files, 0 disables the cache. Atomic as it's adjusted by the frame thread while read by pager threads.
+        std::atomic<size_t> maxCacheSize{0};
+
+        /// when assigned local files are read in batches by the fileReader and decoded from memory, rather than each being opened and read by it's ReaderWriter.
+        /// Files that can't be decoded from memory are passed on to vsg::read(..). The instance() is assigned a fileReader when io_uring is available.
+        vsg::ref_ptr<AsyncFileReader> fileReader;
+
+        /// threads that the files read by the fileReader are decoded on, if not assigned they are decoded by the calling thread.
+        vsg::ref_ptr<vsg::OperationThreads> decodeThreads;
+
+        /// read the paths, the paths that are already being read by another thread are waited on, the rest are read together with a single vsg::read(paths, options).
+        vsg::PathObjects read(const vsg::Paths& paths, vsg::ref_ptr<const vsg::Options> options = {});
+
+        /// return the cached data of path when read with options, null ref_ptr<> if it's not cached.
+        vsg::ref_ptr<vsg::Data> cached(const vsg::Path& path, vsg::ref_ptr<const vsg::Options> options = {});
+
+        /// clear the cache.
+        void clear();
+
+        /// evict the least recently used data until the cache is within maxCacheSize.
+        void trim();
+
+        struct Metrics
+        {
+            uint64_t numRequested = 0; // number of paths requested
+            uint64_t numRead = 0;      // number of paths read
+            uint64_t numCoalesced = 0; // number of paths that waited on another thread's read
+            uint64_t numCacheHits = 0; // number of paths served from the cache
+            uint64_t numFileReads = 0; // number of paths read by the fileReader and decoded from memory
+            size_t cacheSize = 0;      // current size of the cache in bytes
+        };
+
+        Metrics getMetrics() const;
+
+    protected:
+        virtual ~FetchCoalescer();
+
+        // resolved filename, or the unresolved path and the Options it's read with
+        using Key = std::pair<vsg::Path, const vsg::Options*>;
+
+        static Key _key(const vsg::Path& path, const vsg::Options* options);
+        void _cache(const Key& key, vsg::ref_ptr<vsg::Data> data);
+        void _trim();
+        vsg::PathObjects _read(const vsg::Paths& paths, vsg::ref_ptr<const vsg::Options> options);
+
+        using Future = std::shared_future<vsg::ref_ptr<vsg::Object>>;
+        using LRU = std::list<std::pair<Key, vsg::ref_ptr<vsg::Data>>>;
+
+        mutable std::mutex _mutex;
+        std::map<Key, Future> _inFlight;
+        LRU _lru; // most recently used at the front
+        std::map<Key, LRU::iterator> _lruIndex;
+        Metrics _metrics;
+    };
+
+} // namespace vsgGIS
+
+EVSG_type_name(vsgGIS::FetchCoalescer);
@@ -0,0 +1,62 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsgGIS/Export.h>
+#include <vsgGIS/raster_utils.h>
+
+#include <vsg/io/Input.h>
+#include <vsg/io/Output.h>
+#include <vsg/io/Path.h>
+
+#include <limits>
+
+namespace vsgGIS
+{
+
+    /// ImageLayer is an image source composited over the TileDatabaseSettings::imageLayer, such as roads or a classification, so several sources are rendered with a single texture per tile.
+    class VSGGIS_DECLSPEC ImageLayer : public vsg::Inherit<vsg::Object, ImageLayer>
+    {
+    public:
+        /// path of the layer's tiles with {x}, {y} and {z} (level) fields, or a TileArchive.
+        vsg::Path path;
+
+        /// opacity the layer's alpha is multiplied by.
+        float opacity = 1.0f;
+
+        BlendMode blendMode = BLEND_NORMAL;
+
+        /// range of levels that the layer has tiles for, the layer isn't read or composited outside it.
+        uint32_t minLevel = 0;
+        uint32_t maxLevel = std::numeric_limits<uint32_t>::max();
+
+        bool activeAt(uint32_t level) const { return !path.empty() && opacity > 0.0f && level >= minLevel && level <= maxLevel; }
+
+        void read(vsg::Input& input) override;
+        void write(vsg::Output& output) const override;
+    };
+
+} // namespace vsgGIS
+
+EVSG_type_name(vsgGIS::ImageLayer);
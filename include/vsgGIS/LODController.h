@@ -0,0 +1,104 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsgGIS/Export.h>
+#include <vsgGIS/TileMemoryMonitor.h>
+
+#include <vsg/core/observer_ptr.h>
+#include <vsg/nodes/PagedLOD.h>
+
+#include <mutex>
+#include <unordered_map>
+
+namespace vsgGIS
+{
+
+    /// LODController adjusts the screen height ratio at which tiles transition to their subtiles, and the maximum level tiles are refined to, at runtime
+    /// to hold a target frame time, backlog of tile requests and tile memory budget. Each input has separate thresholds for coarsening and refining,
+    /// and a state has to persist for holdFrames before a step is taken, so the level of detail doesn't oscillate around the targets.
+    class VSGGIS_DECLSPEC LODController : public vsg::Inherit<vsg::Object, LODController>
+    {
+    public:
+        /// screenHeightRatio is the finest level of detail the controller will use, and maxLevel the deepest level it will refine to.
+        LODController(double in_screenHeightRatio, uint32_t in_maxLevel);
+
+        /// frame time in milliseconds to hold.
+        double targetFrameTime = 1000.0 / 60.0;
+
+        /// number of vsg::DatabasePager requests, queued or being read and compiled, to hold, 0 to ignore.
+        uint32_t targetNumActiveRequests = 32;
+
+        /// monitor whose tile memory is held to it's maxTileMemory.
+        vsg::ref_ptr<TileMemoryMonitor> memoryMonitor;
+
+        /// fractions of the targets above which the level of detail is coarsened, and below which it is refined.
+        double coarsenThreshold = 1.1;
+        double refineThreshold = 0.8;
+
+        /// number of consecutive frames a state has to persist before a step is taken.
+        uint32_t holdFrames = 30;
+
+        /// factor the screen height ratio is multiplied or divided by on each step.
+        double ratioStep = 1.25;
+
+        /// largest multiple of the finest screen height ratio that coarsening will go to before reducing the maximum level.
+        double maxRatioMultiplier = 4.0;
+
+        /// lowest maximum level that coarsening will reduce to.
+        uint32_t minLevel = 2;
+
+        /// control the PagedLOD of tile x, y, level, where key is tileKey(x, y, level), applying the current screen height ratio and maximum level to it.
+        void track(uint64_t key, vsg::PagedLOD* plod);
+
+        /// update the controller with the time taken by the last frame in milliseconds, excluding time blocked waiting on presentation so a vsync limited frame rate still leaves room to refine,
+        /// and the DatabasePager's numActiveRequests. Call once per frame between frames, as the tracked PagedLOD are updated when a step is taken.
+        void update(double frameTime, uint32_t numActiveRequests = 0);
+
+        /// current screen height ratio and maximum level applied to the tracked PagedLOD.
+        double screenHeightRatio() const;
+        uint32_t maxLevel() const;
+
+    protected:
+        virtual ~LODController();
+
+        void _apply(uint64_t key, vsg::PagedLOD& plod) const;
+        void _applyAll();
+
+        mutable std::mutex _mutex;
+        std::unordered_map<uint64_t, vsg::observer_ptr<vsg::PagedLOD>> _tracked;
+        uint32_t _numTrackedSincePrune = 0;
+
+        const double _finestRatio;
+        const uint32_t _deepestLevel;
+        double _ratio;
+        uint32_t _maxLevel;
+
+        int _state = 0; // -1 while over the targets, 1 while under them, 0 in between
+        uint32_t _stateFrames = 0;
+    };
+
+} // namespace vsgGIS
+
+EVSG_type_name(vsgGIS::LODController);
@@ -0,0 +1,79 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsgGIS/DatasetPool.h>
+#include <vsgGIS/SpatialIndex.h>
+#include <vsgGIS/TileDatabase.h>
+#include <vsgGIS/gdal_utils.h>
+
+#include <limits>
+
+namespace vsgGIS
+{
+
+    /// MosaicIndex is a persistent spatial index over the footprints of many source datasets, such as a directory of GeoTIFF scenes, used to find the datasets that cover a tile
+    /// without checking every dataset's footprint. Footprints are held in the coordinate frame of the TileDatabaseSettings extents so can be queried directly with TileDatabaseSettings::computeTileExtents(..).
+    class VSGGIS_DECLSPEC MosaicIndex : public vsg::Inherit<vsg::Object, MosaicIndex>
+    {
+    public:
+        struct Entry
+        {
+            vsg::Path filename;
+            vsg::dbox extents;       // footprint in the coordinate frame of the TileDatabaseSettings extents
+            double resolution = 0.0; // size of a pixel in the coordinate frame of the extents
+            int32_t priority = 0;    // higher priority datasets are returned first by query(..)
+        };
+
+        std::vector<Entry> entries;
+
+        void read(vsg::Input& input) override;
+        void write(vsg::Output& output) const override;
+
+        /// add all the raster datasets found in directory and it's subdirectories, using numThreads to open them in parallel, 0 selects the number of hardware threads. Return the number of datasets added.
+        size_t build(const vsg::Path& directory, const TileDatabaseSettings& settings, uint32_t numThreads = 0);
+
+        /// compute the entry for a dataset, return false if it has no valid geo transform.
+        static bool computeEntry(GDALDataset& dataset, const TileDatabaseSettings& settings, Entry& entry);
+
+        /// create a width x height image of tile x, y, level of a TileDatabase with settings, reprojecting the datasets that overlap the tile in query(..) order, with each dataset only filling the pixels
+        /// left empty by the ones before it. The datasets are opened through datasetPool so loaders calling from long lived threads reuse their handles. Return null ref_ptr<> if no dataset covers the tile.
+        vsg::ref_ptr<vsg::Data> createImage(const TileDatabaseSettings& settings, uint32_t x, uint32_t y, uint32_t level, uint32_t width, uint32_t height, DatasetPool& datasetPool) const;
+
+        /// add an entry and update the spatial index.
+        void add(const Entry& entry);
+
+        /// rebuild the spatial index, required after modifying entries directly.
+        void update();
+
+        /// return the entries overlapping extents with a resolution between minResolution and maxResolution, ordered by descending priority then finest resolution first.
+        std::vector<const Entry*> query(const vsg::dbox& extents, double minResolution = 0.0, double maxResolution = std::numeric_limits<double>::max()) const;
+
+    protected:
+        SpatialIndex _index;
+    };
+
+} // namespace vsgGIS
+
+EVSG_type_name(vsgGIS::MosaicIndex);
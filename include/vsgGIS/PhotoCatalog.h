@@ -0,0 +1,70 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsgGIS/SpatialIndex.h>
+#include <vsgGIS/TileDatabase.h>
+
+namespace vsgGIS
+{
+
+    /// PhotoCatalog holds the EXIF geotagged locations of a collection of photos, such as a drone survey, with a spatial index so photos near a point or within a tile can be found without rescanning the files.
+    /// Catalogs can be saved and loaded with vsg::write(..)/vsg::read(..), using the .vsgb extension for a compact binary form.
+    class VSGGIS_DECLSPEC PhotoCatalog : public vsg::Inherit<vsg::Object, PhotoCatalog>
+    {
+    public:
+        struct Photo
+        {
+            vsg::Path filename;
+            vsg::dvec3 location; // latitude, longitude and altitude
+        };
+
+        std::vector<Photo> photos;
+
+        void read(vsg::Input& input) override;
+        void write(vsg::Output& output) const override;
+
+        /// add the geotagged photos from filenames, opening them in parallel with numThreads, 0 selects the number of hardware threads. Only the meta data of each file is read.
+        /// Return the number of photos added, files without EXIF_GPSLatitude and EXIF_GPSLongitude are skipped.
+        size_t ingest(const vsg::Paths& filenames, uint32_t numThreads = 0);
+
+        /// rebuild the spatial index, required after modifying photos directly.
+        void update();
+
+        /// return the photos within extents, specified as longitude in x and latitude in y.
+        std::vector<const Photo*> query(const vsg::dbox& extents) const;
+
+        /// return the photos within radius meters of latitude, longitude, ordered nearest first.
+        std::vector<const Photo*> query(double latitude, double longitude, double radius) const;
+
+        /// return the photos within the extents of the specified tile of a TileDatabase.
+        std::vector<const Photo*> query(const TileDatabaseSettings& settings, uint32_t x, uint32_t y, uint32_t level) const;
+
+    protected:
+        SpatialIndex _index;
+    };
+
+} // namespace vsgGIS
+
+EVSG_type_name(vsgGIS::PhotoCatalog);
@@ -0,0 +1,94 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsgGIS/gdal_utils.h>
+
+#include <vsg/maths/box.h>
+
+#include <string>
+#include <vector>
+
+namespace vsgGIS
+{
+
+    class ReprojectionGrid;
+
+    /// Reprojection transforms coordinates between a source and destination coordinate reference system using OGR.
+    /// OGRCoordinateTransformation are expensive to create and not thread safe, so each thread creates one per source and destination pair on first use and caches it for reuse by all Reprojection with the same pair.
+    /// Coordinates are in traditional GIS order, x is easting/longitude and y is northing/latitude.
+    class VSGGIS_DECLSPEC Reprojection : public vsg::Inherit<vsg::Object, Reprojection>
+    {
+    public:
+        /// source and destination may be any definition accepted by OGRSpatialReference::SetFromUserInput(..), such as "EPSG:32633", "WGS84", WKT or PROJ strings.
+        Reprojection(const std::string& in_source, const std::string& in_destination);
+
+        /// return a Reprojection for the source, destination pair, shared with all other callers asking for the same pair.
+        static vsg::ref_ptr<Reprojection> get(const std::string& source, const std::string& destination);
+
+        const std::string source;
+        const std::string destination;
+
+        /// return true if both source and destination were recognized.
+        bool valid() const { return _valid; }
+
+        /// return true if source and destination are the same coordinate reference system so coordinates pass through unchanged.
+        bool identity() const { return _identity; }
+
+        /// transform coordinates in place, return false if any failed to transform.
+        bool transform(size_t count, vsg::dvec3* coords) const;
+
+        bool transform(vsg::dvec3& coord) const { return transform(1, &coord); }
+
+        /// create a ReprojectionGrid that approximates this Reprojection over extents to within errorThreshold, measured in destination units, using at most maxResolution cells along each axis.
+        /// Return null ref_ptr<> if the grid couldn't be created, such as when extents isn't wholly within the valid region of the source coordinate reference system.
+        vsg::ref_ptr<ReprojectionGrid> createGrid(const vsg::dbox& extents, double errorThreshold, uint32_t maxResolution = 64) const;
+
+    protected:
+        bool _valid = false;
+        bool _identity = false;
+    };
+
+    /// ReprojectionGrid approximates a Reprojection over a region by exactly transforming a regular grid of control points and bilinearly interpolating between them,
+    /// making it suitable for transforming the many vertices of a tile mesh or pixels of a raster where an exact transform per coordinate would be too slow.
+    class VSGGIS_DECLSPEC ReprojectionGrid : public vsg::Inherit<vsg::Object, ReprojectionGrid>
+    {
+    public:
+        vsg::dbox extents;              // extents covered in source coordinates
+        uint32_t resolution = 0;        // number of cells along each axis
+        double maxError = 0.0;          // estimated maximum error of interpolated coordinates in destination units
+        std::vector<vsg::dvec3> points; // (resolution + 1) * (resolution + 1) control points in destination coordinates, row by row
+
+        /// return the approximate destination coordinate of a source coordinate, the z value of src is added to the interpolated z value. Coordinates outside extents are extrapolated.
+        vsg::dvec3 transform(const vsg::dvec3& src) const;
+    };
+
+    /// create a width x height image covering extents in the projection coordinate system, sampling the raster bands of dataset with nearest or bilinear filtering.
+    /// Source coordinates of the pixels are interpolated from a ReprojectionGrid accurate to within errorThreshold source pixels. Return null ref_ptr<> if the dataset has no geo transform or doesn't overlap extents.
+    extern VSGGIS_DECLSPEC vsg::ref_ptr<vsg::Data> reprojectToImage(GDALDataset& dataset, const std::string& projection, const vsg::dbox& extents, uint32_t width, uint32_t height, double errorThreshold = 0.125, ResampleMethod method = RESAMPLE_BILINEAR);
+
+} // namespace vsgGIS
+
+EVSG_type_name(vsgGIS::Reprojection);
+EVSG_type_name(vsgGIS::ReprojectionGrid);
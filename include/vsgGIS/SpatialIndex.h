@@ -0,0 +1,102 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsgGIS/Export.h>
+
+#include <vsg/maths/box.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace vsgGIS
+{
+
+    /// SpatialIndex is a packed R-tree over the x, y extents of a set of boxes, bulk loaded using Sort-Tile-Recursive so nodes are fully populated and stored contiguously.
+    /// Used to find the items overlapping a region in logarithmic time rather than testing every item.
+    class VSGGIS_DECLSPEC SpatialIndex
+    {
+    public:
+        /// build the index from boxes, the indices of the boxes are returned by intersect(..).
+        void build(const std::vector<vsg::dbox>& boxes, uint32_t maxNodeSize = 16);
+
+        void clear();
+
+        bool empty() const { return _nodes.empty(); }
+
+        /// call callback(index) for each box whose x, y extents overlap those of box.
+        template<typename F>
+        void intersect(const vsg::dbox& box, F callback) const
+        {
+            if (_nodes.empty()) return;
+
+            uint32_t stack[256];
+            uint32_t stackSize = 0;
+            stack[stackSize++] = static_cast<uint32_t>(_nodes.size() - 1);
+
+            while (stackSize > 0)
+            {
+                const Node& node = _nodes[stack[--stackSize]];
+                if (!overlaps(node.bounds, box)) continue;
+
+                if (node.leaf)
+                {
+                    for (uint32_t i = node.first; i < node.first + node.count; ++i)
+                    {
+                        if (overlaps(_itemBounds[i], box)) callback(_items[i]);
+                    }
+                }
+                else
+                {
+                    for (uint32_t i = node.first; i < node.first + node.count; ++i)
+                    {
+                        stack[stackSize++] = i;
+                    }
+                }
+            }
+        }
+
+        /// return the indices of the boxes whose x, y extents overlap those of box.
+        std::vector<uint32_t> intersect(const vsg::dbox& box) const;
+
+        static bool overlaps(const vsg::dbox& lhs, const vsg::dbox& rhs)
+        {
+            return lhs.min.x <= rhs.max.x && rhs.min.x <= lhs.max.x && lhs.min.y <= rhs.max.y && rhs.min.y <= lhs.max.y;
+        }
+
+    protected:
+        struct Node
+        {
+            vsg::dbox bounds;
+            uint32_t first = 0; // first item for leaves, first child node otherwise
+            uint32_t count = 0;
+            bool leaf = false;
+        };
+
+        std::vector<Node> _nodes; // nodes stored level by level, leaves first and the root last
+        std::vector<uint32_t> _items;
+        std::vector<vsg::dbox> _itemBounds;
+    };
+
+} // namespace vsgGIS
@@ -0,0 +1,64 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsgGIS/Export.h>
+
+#include <vsg/core/Inherit.h>
+#include <vsg/core/Object.h>
+#include <vsg/maths/vec3.h>
+
+#include <vector>
+
+namespace vsgGIS
+{
+
+    /// TerrainMeshBuilder simplifies a square grid of (2^n + 1) x (2^n + 1) vertices into a right-triangulated irregular network (RTIN), an error bounded mesh of right angled triangles
+    /// created by recursively splitting along the hypotenuse only where the surface deviates from the coarser triangle by more than the requested error.
+    /// The error of each split is measured in 3D vertex positions so curvature of the ellipsoid as well as terrain relief is preserved.
+    class VSGGIS_DECLSPEC TerrainMeshBuilder : public vsg::Inherit<vsg::Object, TerrainMeshBuilder>
+    {
+    public:
+        /// gridSize must be 2^n + 1, up to 257 so that vertex indices fit in 16 bits.
+        explicit TerrainMeshBuilder(uint32_t in_gridSize = 33);
+
+        const uint32_t gridSize;
+
+        /// compute the error pyramid of a grid of gridSize x gridSize positions, row by row. The error at each hypotenuse midpoint is the maximum deviation of the surface below the triangles it splits.
+        std::vector<float> computeErrors(const vsg::vec3* positions) const;
+
+        /// create a mesh with a maximum error of maxError, a negative maxError creates the full resolution mesh.
+        /// gridIndices is filled in with the grid index, c + r * gridSize, of each vertex used, and indices with the triangles indexing gridIndices, wound counter clockwise with row 0 at the bottom.
+        /// Return the geometric error of the mesh, the maximum error of the triangles that weren't split.
+        float createMesh(const std::vector<float>& errors, float maxError, std::vector<uint32_t>& gridIndices, std::vector<uint16_t>& indices) const;
+
+    protected:
+        // a, b grid coordinates of the hypotenuse of each triangle of the full binary triangle tree, parents before children
+        std::vector<uint16_t> _coords;
+        uint32_t _numParentTriangles = 0;
+    };
+
+} // namespace vsgGIS
+
+EVSG_type_name(vsgGIS::TerrainMeshBuilder);
@@ -0,0 +1,235 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsgGIS/Export.h>
+
+#include <vsg/core/Array.h>
+#include <vsg/core/Data.h>
+#include <vsg/io/Options.h>
+#include <vsg/io/Path.h>
+
+#include <array>
+#include <fstream>
+#include <vector>
+
+namespace vsgGIS
+{
+
+    /// interleave the bits of x and y to form a Morton (Z-order) code, the four children of a quad tree tile map to four consecutive codes.
+    inline uint64_t morton2D(uint32_t x, uint32_t y)
+    {
+        auto spread = [](uint64_t v) {
+            v &= 0x00000000ffffffffull;
+            v = (v | (v << 16)) & 0x0000ffff0000ffffull;
+            v = (v | (v << 8)) & 0x00ff00ff00ff00ffull;
+            v = (v | (v << 4)) & 0x0f0f0f0f0f0f0f0full;
+            v = (v | (v << 2)) & 0x3333333333333333ull;
+            v = (v | (v << 1)) & 0x5555555555555555ull;
+            return v;
+        };
+        return spread(x) | (spread(y) << 1);
+    }
+
+    /// inverse of morton2D(..), extract the x and y values from a Morton code.
+    inline void inverseMorton2D(uint64_t code, uint32_t& x, uint32_t& y)
+    {
+        auto compact = [](uint64_t v) {
+            v &= 0x5555555555555555ull;
+            v = (v | (v >> 1)) & 0x3333333333333333ull;
+            v = (v | (v >> 2)) & 0x0f0f0f0f0f0f0f0full;
+            v = (v | (v >> 4)) & 0x00ff00ff00ff00ffull;
+            v = (v | (v >> 8)) & 0x0000ffff0000ffffull;
+            v = (v | (v >> 16)) & 0x00000000ffffffffull;
+            return static_cast<uint32_t>(v);
+        };
+        x = compact(code);
+        y = compact(code >> 1);
+    }
+
+    /// key used to order tiles, level in the top 6 bits and the Morton code of x, y in the lower 58 bits so that all the tiles of a level are contiguous and siblings are adjacent.
+    inline uint64_t tileKey(uint32_t x, uint32_t y, uint32_t level)
+    {
+        return (uint64_t(level) << 58) | (morton2D(x, y) & 0x03ffffffffffffffull);
+    }
+
+    /// TileArchive provides read access to a single file packing all the tiles of a layer, with a compact index sorted by tileKey(x, y, level).
+    /// The file is memory mapped, raw and block compressed payloads are returned as vsg::Data that directly reference the mapped bytes.
+    class VSGGIS_DECLSPEC TileArchive : public vsg::Inherit<vsg::Object, TileArchive>
+    {
+    public:
+        TileArchive();
+        TileArchive(const TileArchive&) = delete;
+        TileArchive& operator=(const TileArchive&) = delete;
+
+        /// file extension used to recognize TileArchive files.
+        static constexpr const char* fileExtension = ".vsgtiles";
+
+        static constexpr uint32_t VERSION = 2;
+
+        enum PayloadType : uint8_t
+        {
+            RAW = 0,    // image data laid out as vsg::Data, directly usable as a texture
+            ENCODED = 1 // image file held in memory, such as .png or .jpg, decoded with vsg::read(..)
+        };
+
+        /// meta data values held by an Entry, restored on the vsg::Data read from the archive.
+        enum ValueMask : uint32_t
+        {
+            OFFSET_VALUE = 1 << 0,       // "offset"
+            SCALE_VALUE = 1 << 1,        // "scale"
+            NODATA_VALUE = 1 << 2,       // "NoDataValue"
+            NODATA_SAMPLE_VALUE = 1 << 3 // "NoDataSample"
+        };
+
+        struct Header
+        {
+            char magic[8];
+            uint32_t version;
+            uint32_t entrySize;
+            uint64_t numEntries;
+            uint64_t indexOffset;
+        };
+
+        struct Entry
+        {
+            uint64_t key;
+            uint64_t offset;
+            uint64_t size;
+            uint32_t format;      // VkFormat of RAW payloads
+            uint32_t width;       // width of RAW payloads in values, or blocks for block compressed formats
+            uint32_t height;      // height of RAW payloads in values, or blocks for block compressed formats
+            uint16_t stride;      // size of each value in bytes
+            uint8_t payloadType;  // PayloadType
+            uint8_t origin;       // vsg::Origin
+            uint8_t blockWidth;   // block dimensions of block compressed formats, 1 for uncompressed formats
+            uint8_t blockHeight;
+            uint8_t maxNumMipmaps; // number of mipmap levels included in RAW payloads
+            char extension[5];     // extension of ENCODED payloads, excluding the leading '.'
+            uint32_t valueMask;    // ValueMask of the meta data values below that are set
+            uint32_t reserved;
+            double offsetValue; // value = offset + scale * sample of quantized terrain
+            double scaleValue;
+            double noDataValue;
+            double noDataSample; // reserved raw sample of quantized terrain that represents NoData
+        };
+
+        /// open archive, memory mapping it's contents. Return true on success.
+        bool open(const vsg::Path& filename);
+
+        /// release the memory mapping. vsg::Data returned by read(..) keep the archive alive, so only call close() explicitly once they are no longer in use.
+        void close();
+
+        bool valid() const { return _begin != nullptr; }
+
+        const vsg::Path& filename() const { return _filename; }
+        size_t size() const { return _size; }
+        size_t numEntries() const { return _numEntries; }
+
+        /// return the index entry for the specified tile, nullptr if it's not in the archive.
+        const Entry* find(uint32_t x, uint32_t y, uint32_t level) const;
+
+        /// read the specified tile, return null ref_ptr<> if it's not in the archive.
+        vsg::ref_ptr<vsg::Data> read(uint32_t x, uint32_t y, uint32_t level, vsg::ref_ptr<const vsg::Options> options = {}) const;
+
+        /// read the four children at level+1 of the specified tile, ordered by Morton order (x, y), (x+1, y), (x, y+1), (x+1, y+1). As siblings are adjacent in the archive this is a single contiguous read.
+        std::array<vsg::ref_ptr<vsg::Data>, 4> readChildren(uint32_t x, uint32_t y, uint32_t level, vsg::ref_ptr<const vsg::Options> options = {}) const;
+
+    protected:
+        virtual ~TileArchive();
+
+        vsg::ref_ptr<vsg::Data> createData(const Entry& entry, vsg::ref_ptr<const vsg::Options> options) const;
+
+        vsg::Path _filename;
+        uint8_t* _begin = nullptr;
+        size_t _size = 0;
+        bool _mapped = false;
+        const Entry* _entries = nullptr;
+        size_t _numEntries = 0;
+    };
+
+    /// TileArchiveWriter writes tiles out to a TileArchive file as they are added, so that only the index is held in memory.
+    /// Tiles must be added in ascending tileKey(x, y, level) order so that siblings are stored adjacent to each other.
+    class VSGGIS_DECLSPEC TileArchiveWriter : public vsg::Inherit<vsg::Object, TileArchiveWriter>
+    {
+    public:
+        TileArchiveWriter();
+
+        /// open the archive file for writing, return true on success.
+        bool open(const vsg::Path& filename);
+
+        /// write tile image data as a RAW payload, return true on success.
+        bool add(uint32_t x, uint32_t y, uint32_t level, vsg::ref_ptr<vsg::Data> data);
+
+        /// write an encoded image file, such as the contents of a .png or .jpg, to be decoded on read. Return true on success.
+        bool add(uint32_t x, uint32_t y, uint32_t level, vsg::ref_ptr<vsg::ubyteArray> encoded, const std::string& extension);
+
+        size_t size() const { return _entries.size(); }
+
+        /// write the index and close the file, return true on success.
+        bool close();
+
+    protected:
+        virtual ~TileArchiveWriter();
+
+        bool _add(uint64_t key, const vsg::Data& data, const std::string& extension);
+        uint64_t _writeAligned(const void* ptr, uint64_t size);
+
+        vsg::Path _filename;
+        std::ofstream _fout;
+        uint64_t _offset = 0;
+        std::vector<TileArchive::Entry> _entries;
+    };
+
+    /// TileArchiveBuilder collects tiles and writes them out to a TileArchive file, sorting payloads so that siblings are stored adjacent to each other.
+    class VSGGIS_DECLSPEC TileArchiveBuilder : public vsg::Inherit<vsg::Object, TileArchiveBuilder>
+    {
+    public:
+        /// add tile image data to be written as a RAW payload.
+        void add(uint32_t x, uint32_t y, uint32_t level, vsg::ref_ptr<vsg::Data> data);
+
+        /// add an encoded image file, such as the contents of a .png or .jpg, to be decoded on read.
+        void add(uint32_t x, uint32_t y, uint32_t level, vsg::ref_ptr<vsg::ubyteArray> encoded, const std::string& extension);
+
+        size_t size() const { return _tiles.size(); }
+
+        /// write all the tiles added to the specified archive file, return true on success.
+        bool write(const vsg::Path& filename) const;
+
+    protected:
+        struct Tile
+        {
+            uint64_t key;
+            vsg::ref_ptr<vsg::Data> data;
+            std::string extension;
+        };
+
+        std::vector<Tile> _tiles;
+    };
+
+} // namespace vsgGIS
+
+EVSG_type_name(vsgGIS::TileArchive);
+EVSG_type_name(vsgGIS::TileArchiveWriter);
+EVSG_type_name(vsgGIS::TileArchiveBuilder);
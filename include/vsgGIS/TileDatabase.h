@@ -1,21 +1,62 @@
 #pragma once
 
+#include <vsgGIS/DatasetPool.h>
+#include <vsgGIS/ElevationIndex.h>
 #include <vsgGIS/Export.h>
+#include <vsgGIS/FetchCoalescer.h>
+#include <vsgGIS/ImageLayer.h>
+#include <vsgGIS/LODController.h>
+#include <vsgGIS/Reprojection.h>
+#include <vsgGIS/TerrainMeshBuilder.h>
+#include <vsgGIS/TileArchive.h>
+#include <vsgGIS/TileMemoryMonitor.h>
+#include <vsgGIS/TilePrefetcher.h>
+#include <vsgGIS/TileRenderContext.h>
+#include <vsgGIS/TileRequestScheduler.h>
 
 #include <vsg/all.h>
 
+#include <memory>
+#include <mutex>
+
 namespace vsgGIS
 {
 
     extern VSGGIS_DECLSPEC bool init();
 
+    class MosaicIndex;
+
     class VSGGIS_DECLSPEC TileDatabaseSettings : public vsg::Inherit<vsg::Object, TileDatabaseSettings>
     {
     public:
+        /// version of the serialized settings, written after the original fields so the fields added since can be appended behind it.
+        static constexpr uint32_t VERSION = 1;
+
         // read/write of TileReader settings
         void read(vsg::Input& input) override;
         void write(vsg::Output& output) const override;
 
+        /// convert a location in the coordinate frame of the extents to latitude, longitude and altitude.
+        vsg::dvec3 computeLatitudeLongitudeAltitude(const vsg::dvec3& src) const;
+
+        /// convert a latitude, longitude and altitude to a location in the coordinate frame of the extents, the inverse of computeLatitudeLongitudeAltitude(..).
+        vsg::dvec3 computeTileLocation(const vsg::dvec3& latitudeLongitudeAltitude) const;
+
+        /// compute the extents of the specified tile in the coordinate frame of the extents.
+        vsg::dbox computeTileExtents(uint32_t x, uint32_t y, uint32_t level) const;
+
+        /// compute the x, y of the tile at level that contains location, specified in the coordinate frame of the extents. Return false if location is outside the extents.
+        bool computeTileCoordinates(const vsg::dvec3& location, uint32_t level, uint32_t& x, uint32_t& y) const;
+
+        /// return the path of the specified tile of a layer, substituting the {x}, {y} and {z} (level) fields of layer.
+        vsg::Path getTilePath(const vsg::Path& layer, uint32_t x, uint32_t y, uint32_t level) const;
+
+        /// return the Reprojection from the coordinate frame of the extents to longitude, latitude, null if the projection is geographic or spherical mercator which are computed directly.
+        vsg::ref_ptr<Reprojection> getReprojection() const;
+
+        /// return the Reprojection from longitude, latitude to the coordinate frame of the extents, the inverse of getReprojection().
+        vsg::ref_ptr<Reprojection> getInverseReprojection() const;
+
         // defaults for readymap
         vsg::dbox extents = {{-180.0, -90.0, 0.0}, {180.0, 90.0, 1.0}};
         uint32_t noX = 2;
@@ -25,11 +66,36 @@ namespace vsgGIS
         double lodTransitionScreenHeightRatio = 0.25;
 
         std::string projection;
+        double reprojectionErrorThreshold = 1e-7; // maximum error, in degrees, of the approximate reprojection used for tile vertices
+        double terrainMeshError = 0.1;            // maximum error of simplified tile meshes as a fraction of the tile's grid spacing, negative disables simplification
+        bool compactVertices = true;              // use 16 bit positions quantized to each tile's bounding box and 16 bit tex coords for ECEF tiles
+        double prefetchLookAheadTime = 0.0;       // time in seconds of predicted camera motion to prefetch tiles for, 0 disables prefetching
+        uint32_t prefetchCacheSize = 256;         // minimum size in megabytes of the FetchCoalescer cache that prefetched tiles are loaded into
+        uint32_t tileMemoryBudget = 0;            // maximum megabytes held by this database's resident tiles, 0 for no limit
+        uint32_t gdalCacheBudget = 0;             // maximum megabytes held in GDAL's raster block cache, 0 for no limit
+        bool releaseDataAfterTransfer = true;     // release the CPU copies of tile textures, vertices and indices once they have been transferred to the GPU
+        double targetFrameTime = 0.0;             // frame time in milliseconds for the LODController to hold by adjusting the LOD transition ratio and maximum level, 0 disables the LODController
         vsg::ref_ptr<vsg::EllipsoidModel> ellipsoidModel = vsg::EllipsoidModel::create();
 
         vsg::Path imageLayer;
+        std::vector<vsg::ref_ptr<ImageLayer>> overlayLayers; // image layers composited in order over the imageLayer into a single texture per tile
         vsg::Path terrainLayer;
         uint32_t mipmapLevelsHint = 16;
+
+    protected:
+        // the Reprojections resolved for a projection, cached so the per vertex and per query conversions don't go through Reprojection::get(..)
+        struct Reprojections
+        {
+            std::string projection;
+            vsg::ref_ptr<Reprojection> toGeographic;
+            vsg::ref_ptr<Reprojection> fromGeographic;
+        };
+
+        // return the Reprojections for the current projection, resolving them again if the projection has changed
+        std::shared_ptr<const Reprojections> _getReprojections() const;
+
+        // the Reprojections of the last projection resolved, swapped with std::atomic_load/atomic_store so the settings remain copyable and only the current Reprojections are kept
+        mutable std::shared_ptr<const Reprojections> _reprojections;
     };
 
     class VSGGIS_DECLSPEC TileDatabase : public vsg::Inherit<vsg::Node, TileDatabase>
@@ -38,6 +104,22 @@ namespace vsgGIS
         vsg::ref_ptr<TileDatabaseSettings> settings;
         vsg::ref_ptr<vsg::Node> child;
 
+        // heights of the resident terrain tiles, assigned by readDatabase(..)
+        vsg::ref_ptr<ElevationIndex> elevationIndex;
+
+        // priority ordering and cancellation of stale subtile requests, assigned by readDatabase(..). Call scheduler->advance(frameStamp->frameCount) each frame
+        // so requests for tiles the camera has left are judged stale even when no PagedLOD still in view is examined.
+        vsg::ref_ptr<TileRequestScheduler> scheduler;
+
+        // predictive prefetching of tiles, assigned by readDatabase(..) when settings->prefetchLookAheadTime > 0. Call prefetcher->update(eye, time) each frame to drive it.
+        vsg::ref_ptr<TilePrefetcher> prefetcher;
+
+        // accounting of the memory held by the tiles, assigned by readDatabase(..). Call memoryMonitor->enforce(pager) each frame to keep within the tileMemoryBudget and gdalCacheBudget.
+        vsg::ref_ptr<TileMemoryMonitor> memoryMonitor;
+
+        // adaptive level of detail, assigned by readDatabase(..) when settings->targetFrameTime > 0. Call lodController->update(frameTime, databasePager->numActiveRequests) each frame to drive it.
+        vsg::ref_ptr<LODController> lodController;
+
         template<class N, class V>
         static void t_traverse(N& node, V& visitor)
         {
@@ -53,6 +135,12 @@ namespace vsgGIS
         void write(vsg::Output& output) const override;
 
         bool readDatabase(vsg::ref_ptr<const vsg::Options> options);
+
+        /// return the terrain height and normal at latitude, longitude from the highest resolution resident terrain tile, see ElevationIndex::query(..).
+        ElevationIndex::Result queryHeight(double latitude, double longitude) const;
+
+        /// batched version of queryHeight(..) for ground clamping many points at once.
+        void queryHeights(size_t count, const vsg::dvec2* latitudeLongitudes, ElevationIndex::Result* results) const;
     };
 
     class VSGGIS_DECLSPEC TileReader : public vsg::Inherit<vsg::ReaderWriter, TileReader>
@@ -60,6 +148,33 @@ namespace vsgGIS
     public:
         vsg::ref_ptr<TileDatabaseSettings> settings;
 
+        // heights of the tiles read, created by init(..) if not already assigned
+        vsg::ref_ptr<ElevationIndex> elevationIndex;
+
+        // worker threads that the subtiles of a read are built on, assigned defaultBuildThreads() by init(..) if not already assigned
+        vsg::ref_ptr<vsg::OperationThreads> buildThreads;
+
+        // process wide worker threads shared by the TileReaders, and used as the decodeThreads of FetchCoalescer::instance()
+        static vsg::ref_ptr<vsg::OperationThreads>& defaultBuildThreads();
+
+        // priority ordering and cancellation of stale subtile requests, with metrics of the cancelled work, created by init(..) if not already assigned
+        vsg::ref_ptr<TileRequestScheduler> scheduler;
+
+        // coalesces concurrent reads of the same tile files, assigned FetchCoalescer::instance() by init(..) if not already assigned
+        vsg::ref_ptr<FetchCoalescer> fetchCoalescer;
+
+        // per thread GDAL handles that the datasets of a mosaic imageLayer are read through on the pager threads, assigned DatasetPool::instance() by init(..) if not already assigned
+        vsg::ref_ptr<DatasetPool> datasetPool;
+
+        // width and height of the tile images created from a mosaic imageLayer
+        uint32_t mosaicTileSize = 256;
+
+        // accounting of the memory held by the tiles created, created by init(..) if not already assigned
+        vsg::ref_ptr<TileMemoryMonitor> memoryMonitor;
+
+        // adjusts the LOD transition of the tiles created to hold frame time, request backlog and memory targets, created by init(..) when settings->targetFrameTime > 0 if not already assigned
+        vsg::ref_ptr<LODController> lodController;
+
         // read/write of TileReader settings
         void read(vsg::Input& input) override;
         void write(vsg::Output& output) const override;
@@ -70,6 +185,9 @@ namespace vsgGIS
         // read the tile
         vsg::ref_ptr<vsg::Object> read(const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options = {}) const override;
 
+        // load the image and terrain data of a tile into the fetchCoalescer's cache ahead of it being requested, return the number of bytes loaded.
+        size_t prefetch(uint32_t x, uint32_t y, uint32_t level, vsg::ref_ptr<const vsg::Options> options = {}) const;
+
         // timing stats
         mutable std::mutex statsMutex;
         mutable uint64_t numTilesRead{0};
@@ -80,19 +198,63 @@ namespace vsgGIS
         vsg::dbox computeTileExtents(uint32_t x, uint32_t y, uint32_t level) const;
         vsg::Path getTilePath(const vsg::Path& src, uint32_t x, uint32_t y, uint32_t level) const;
 
+        // add the heights attached to a tile as a "Heights" vsg::floatArray2D to the elevationIndex
+        void registerTile(uint32_t x, uint32_t y, uint32_t level, vsg::Node* tile) const;
+
+        struct TileData
+        {
+            uint32_t x;
+            uint32_t y;
+            vsg::ref_ptr<vsg::Data> image;
+            vsg::ref_ptr<vsg::Data> terrain;
+            std::vector<vsg::ref_ptr<vsg::Data>> overlays; // data of each of the settings->overlayLayers
+        };
+
+        // read the image, terrain and overlay data of tiles at level that haven't already been assigned, the tiles not held in archives are all fetched with a single batched vsg::read(..).
+        // The overlays active at level are then composited onto the image.
+        void readTiles(std::vector<TileData>& tiles, uint32_t level, vsg::ref_ptr<const vsg::Options> options) const;
+
         vsg::ref_ptr<vsg::Object> read_root(vsg::ref_ptr<const vsg::Options> options = {}) const;
         vsg::ref_ptr<vsg::Object> read_subtile(uint32_t x, uint32_t y, uint32_t lod, vsg::ref_ptr<const vsg::Options> options = {}) const;
 
-        vsg::ref_ptr<vsg::Node> createTile(const vsg::dbox& tile_extents, vsg::ref_ptr<vsg::Data> sourceData) const;
-        vsg::ref_ptr<vsg::Node> createECEFTile(const vsg::dbox& tile_extents, vsg::ref_ptr<vsg::Data> sourceData) const;
-        vsg::ref_ptr<vsg::Node> createTextureQuad(const vsg::dbox& tile_extents, vsg::ref_ptr<vsg::Data> sourceData) const;
+        // sample the terrain data onto a numColumns x numRows grid of heights over the tile extents, with row 0 at the minimum y. When terrainData is null the heights of the resident parent tile are used.
+        // Returns null ref_ptr<> if there is no terrainLayer.
+        vsg::ref_ptr<vsg::floatArray2D> createHeights(const vsg::dbox& tile_extents, vsg::ref_ptr<vsg::Data> terrainData, uint32_t numColumns, uint32_t numRows) const;
+
+        // bounds of a tile computed as it's created, orientedBox maps the -1 to 1 unit cube onto the tile's oriented bounding box
+        struct TileBounds
+        {
+            vsg::dsphere sphere;
+            vsg::dmat4 orientedBox;
+        };
+
+        vsg::ref_ptr<vsg::Node> createTile(const vsg::dbox& tile_extents, vsg::ref_ptr<vsg::Data> sourceData, vsg::ref_ptr<vsg::Data> terrainData, TileBounds& bounds) const;
+        vsg::ref_ptr<vsg::Node> createECEFTile(const vsg::dbox& tile_extents, vsg::ref_ptr<vsg::Data> sourceData, vsg::ref_ptr<vsg::floatArray2D> heights, TileBounds& bounds) const;
+        vsg::ref_ptr<vsg::Node> createTextureQuad(const vsg::dbox& tile_extents, vsg::ref_ptr<vsg::Data> sourceData, TileBounds& bounds) const;
 
         vsg::ref_ptr<vsg::StateGroup> createRoot() const;
 
+        // pipeline and sampler shared between TileReader with the same rendering settings, assigned by init(..) if not already assigned
+        vsg::ref_ptr<TileRenderContext> renderContext;
+
         vsg::ref_ptr<vsg::DescriptorSetLayout> descriptorSetLayout;
         vsg::ref_ptr<vsg::PipelineLayout> pipelineLayout;
         vsg::ref_ptr<vsg::Sampler> sampler;
         vsg::ref_ptr<vsg::GraphicsPipeline> graphicsPipeline;
+
+        // archives used in place of individual tile files when the imageLayer or terrainLayer is a TileArchive
+        vsg::ref_ptr<TileArchive> imageArchive;
+        vsg::ref_ptr<TileArchive> terrainArchive;
+        std::vector<vsg::ref_ptr<TileArchive>> overlayArchives; // indexed by settings->overlayLayers, null for layers not held in archives
+
+        // index of source datasets that tile images are reprojected from when the imageLayer is a MosaicIndex file rather than a tile template
+        vsg::ref_ptr<MosaicIndex> imageMosaic;
+
+        // composite the overlays of tile onto a copy of it's image, return false if the image couldn't be composited onto
+        bool compositeOverlays(TileData& tile, uint32_t level) const;
+
+        // simplifies the tile grids to error bounded meshes
+        vsg::ref_ptr<TerrainMeshBuilder> meshBuilder;
     };
 
 } // namespace vsgGIS
@@ -0,0 +1,113 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsgGIS/FetchCoalescer.h>
+
+#include <vsg/core/Object.h>
+#include <vsg/threading/DatabasePager.h>
+
+#include <atomic>
+
+namespace vsgGIS
+{
+
+    /// TileMemoryMonitor accounts for the memory held by the tiles of a TileDatabase, by category, along with the caches the tiles are loaded through,
+    /// and enforces a budget on the tiles by lowering the DatabasePager's target number of high resolution PagedLOD, so the least recently visible subtrees are expired early.
+    /// The FetchCoalescer cache is shared by all the TileDatabase so isn't part of any one database's budget, it's bounded once for the whole process by it's own maxCacheSize.
+    class VSGGIS_DECLSPEC TileMemoryMonitor : public vsg::Inherit<vsg::Object, TileMemoryMonitor>
+    {
+    public:
+        TileMemoryMonitor();
+
+        enum Category
+        {
+            IMAGE_DATA = 0,
+            VERTEX_DATA,
+            INDEX_DATA,
+            HEIGHTS,
+            NUM_CATEGORIES
+        };
+
+        struct Usage
+        {
+            uint64_t bytes[NUM_CATEGORIES] = {};
+            uint64_t gpuOnlyBytes = 0; // part of bytes only held on the GPU, as the system memory copy is released once transferred
+            uint64_t numDescriptorSets = 0;
+            uint64_t numTiles = 0;
+
+            uint64_t total() const
+            {
+                uint64_t sum = 0;
+                for (auto b : bytes) sum += b;
+                return sum;
+            }
+
+            /// bytes held in system memory.
+            uint64_t systemMemory() const { return total() - gpuOnlyBytes; }
+        };
+
+        struct Report
+        {
+            Usage tiles;                 // memory held by the resident tiles
+            uint64_t fetchCacheSize = 0; // bytes held in the FetchCoalescer cache
+            uint64_t gdalCacheSize = 0;  // bytes held in GDAL's raster block cache, which is shared by the whole process
+        };
+
+        /// maximum bytes held in system memory by the resident tiles, 0 for no limit.
+        uint64_t maxTileMemory = 0;
+
+        /// maximum bytes held in GDAL's raster block cache, 0 for no limit.
+        uint64_t maxGDALCache = 0;
+
+        /// cache that tiles are loaded through, it's size is reported but not included in the tile memory budget.
+        vsg::ref_ptr<FetchCoalescer> fetchCoalescer;
+
+        /// account for the memory held by tile, the accounting is released when tile is deleted.
+        void track(vsg::Object* tile, const Usage& usage);
+
+        /// return the current accounting.
+        Report getReport() const;
+
+        /// enforce the budgets, call once per frame. When tile memory is over budget the pager's targetMaxNumPagedLODWithHighResSubgraphs is reduced in proportion, and restored once back under budget.
+        void enforce(vsg::DatabasePager& pager);
+
+    protected:
+        virtual ~TileMemoryMonitor();
+
+        struct Record;
+
+        void _release(const Usage& usage);
+
+        std::atomic_uint64_t _bytes[NUM_CATEGORIES];
+        std::atomic_uint64_t _gpuOnlyBytes{0};
+        std::atomic_uint64_t _numDescriptorSets{0};
+        std::atomic_uint64_t _numTiles{0};
+
+        uint32_t _pagerTarget = 0; // targetMaxNumPagedLODWithHighResSubgraphs of the pager before enforcement lowered it
+    };
+
+} // namespace vsgGIS
+
+EVSG_type_name(vsgGIS::TileMemoryMonitor);
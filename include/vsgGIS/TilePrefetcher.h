@@ -0,0 +1,104 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsgGIS/Export.h>
+
+#include <vsg/io/Options.h>
+#include <vsg/maths/vec3.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+
+namespace vsgGIS
+{
+
+    class TileReader;
+
+    /// TilePrefetcher extrapolates the camera's motion to predict the tiles that the DatabasePager will request over the next lookAheadTime seconds,
+    /// and loads them ahead of time into the FetchCoalescer cache of the TileReader, so that by the time they are requested they are served from memory.
+    /// Loads run on a single low priority background thread, capped to maxBandwidth and paused while on demand requests are waiting for the TileRequestScheduler.
+    class VSGGIS_DECLSPEC TilePrefetcher : public vsg::Inherit<vsg::Object, TilePrefetcher>
+    {
+    public:
+        TilePrefetcher(vsg::ref_ptr<TileReader> in_reader, vsg::ref_ptr<const vsg::Options> in_options);
+
+        TilePrefetcher(const TilePrefetcher&) = delete;
+        TilePrefetcher& operator=(const TilePrefetcher&) = delete;
+
+        /// time in seconds ahead of the camera to prefetch for.
+        double lookAheadTime = 0.5;
+
+        /// number of positions along the predicted path that tiles are selected at.
+        uint32_t numPredictions = 4;
+
+        /// vertical field of view of the camera in degrees, used to estimate the screen height ratio of tiles in the same way as the PagedLOD tests.
+        double fieldOfViewY = 30.0;
+
+        /// maximum number of bytes per second loaded by prefetching.
+        double maxBandwidth = 64.0 * 1024.0 * 1024.0;
+
+        /// update the predicted motion with the camera's eye point in ECEF coordinates at time, in seconds, and queue the tiles along the predicted path.
+        void update(const vsg::dvec3& eye, double time);
+
+        struct Metrics
+        {
+            uint64_t numQueued = 0;     // tiles queued for prefetching
+            uint64_t numPrefetched = 0; // tiles loaded into the cache
+            uint64_t numDeferred = 0;   // times prefetching paused for on demand requests or the bandwidth cap
+            uint64_t bytesLoaded = 0;
+        };
+
+        Metrics getMetrics() const;
+
+    protected:
+        virtual ~TilePrefetcher();
+
+        void _queueTiles(const vsg::dvec3& eye);
+        void _run();
+
+        vsg::ref_ptr<TileReader> _reader;
+        vsg::ref_ptr<const vsg::Options> _options;
+
+        // motion of the camera
+        bool _hasPrevious = false;
+        vsg::dvec3 _previousEye;
+        double _previousTime = 0.0;
+        vsg::dvec3 _velocity;
+
+        mutable std::mutex _mutex;
+        std::condition_variable _condition;
+        std::deque<uint64_t> _queue;           // tileKey(..) of the tiles to prefetch, most urgent first
+        std::unordered_set<uint64_t> _queued; // tiles already queued or prefetched, so they aren't requested again
+        Metrics _metrics;
+        bool _done = false;
+        std::thread _thread;
+    };
+
+} // namespace vsgGIS
+
+EVSG_type_name(vsgGIS::TilePrefetcher);
@@ -0,0 +1,80 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsgGIS/Export.h>
+
+#include <vsg/io/Options.h>
+#include <vsg/state/GraphicsPipeline.h>
+#include <vsg/state/Sampler.h>
+
+#include <string>
+#include <tuple>
+
+namespace vsgGIS
+{
+
+    /// TileRenderContext holds the DescriptorSetLayout, PipelineLayout, Sampler and GraphicsPipeline that tiles are rendered with.
+    /// Contexts are shared by all the TileReader whose settings give the same Key, so loading several databases compiles the pipeline once,
+    /// and as their root StateGroup share the same BindGraphicsPipeline the pipeline isn't rebound when traversing from one database to the next.
+    class VSGGIS_DECLSPEC TileRenderContext : public vsg::Inherit<vsg::Object, TileRenderContext>
+    {
+    public:
+        /// the settings that the pipeline and sampler depend upon.
+        struct Key
+        {
+            uint32_t mipmapLevelsHint = 16;
+            bool compactVertices = true;
+            std::string vertexShader;   // path of the vertex shader found using the Options, empty when the built in shader is used
+            std::string fragmentShader; // path of the fragment shader found using the Options, empty when the built in shader is used
+
+            bool operator<(const Key& rhs) const
+            {
+                return std::tie(mipmapLevelsHint, compactVertices, vertexShader, fragmentShader) < std::tie(rhs.mipmapLevelsHint, rhs.compactVertices, rhs.vertexShader, rhs.fragmentShader);
+            }
+        };
+
+        explicit TileRenderContext(const Key& in_key, vsg::ref_ptr<const vsg::Options> options = {});
+
+        /// return the key, with the shader paths resolved using options, for the specified settings.
+        static Key createKey(uint32_t mipmapLevelsHint, bool compactVertices, vsg::ref_ptr<const vsg::Options> options);
+
+        /// return the context for key, reusing an existing context when one is still in use, otherwise creating a new one.
+        static vsg::ref_ptr<TileRenderContext> get(const Key& key, vsg::ref_ptr<const vsg::Options> options = {});
+
+        const Key key;
+
+        vsg::ref_ptr<vsg::DescriptorSetLayout> descriptorSetLayout;
+        vsg::ref_ptr<vsg::PipelineLayout> pipelineLayout;
+        vsg::ref_ptr<vsg::Sampler> sampler;
+        vsg::ref_ptr<vsg::GraphicsPipeline> graphicsPipeline;
+        vsg::ref_ptr<vsg::BindGraphicsPipeline> bindGraphicsPipeline;
+
+    protected:
+        virtual ~TileRenderContext();
+    };
+
+} // namespace vsgGIS
+
+EVSG_type_name(vsgGIS::TileRenderContext);
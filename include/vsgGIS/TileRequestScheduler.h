@@ -0,0 +1,121 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsgGIS/Export.h>
+
+#include <vsg/core/observer_ptr.h>
+#include <vsg/nodes/PagedLOD.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+
+namespace vsgGIS
+{
+
+    /// TileRequestScheduler tracks the subtile requests made by the DatabasePager to a TileReader, keyed by tileKey(x, y, level) of the tile whose PagedLOD made the request.
+    /// Requests are admitted to the expensive stages in order of the latest screen space priority of their PagedLOD, and requests whose PagedLOD is no longer
+    /// wanting it's high resolution child are cancelled before they start the next stage, so a fast moving camera doesn't leave a backlog of stale loads.
+    /// Cancelled requests return no subgraph to the DatabasePager, so the tile will be requested again if it comes back into view.
+    class VSGGIS_DECLSPEC TileRequestScheduler : public vsg::Inherit<vsg::Object, TileRequestScheduler>
+    {
+    public:
+        /// maxActiveRequests of 0 uses the number of hardware threads.
+        explicit TileRequestScheduler(uint32_t in_maxActiveRequests = 0);
+
+        enum Stage
+        {
+            QUEUED = 0, // waiting to be admitted
+            FETCH,      // reading and decoding the tile data
+            BUILD,      // creating the heights, meshes and state of the tiles
+            NUM_STAGES
+        };
+
+        /// maximum number of requests admitted at once, waiting requests are admitted in priority order as active requests end.
+        uint32_t maxActiveRequests;
+
+        /// number of frames since a PagedLOD last used it's high resolution child after which it's request is treated as stale.
+        uint64_t staleFrameCount = 30;
+
+        /// track the PagedLOD that will request the subtiles of the tile x, y, level, so it's priority and last use can be checked.
+        void track(uint64_t key, vsg::PagedLOD* plod);
+
+        /// advance the frame count used to judge whether requests are stale, call once per frame with the FrameStamp's frameCount.
+        /// The frame count is also advanced to the latest frame seen on the tracked PagedLOD, but that alone can't judge requests stale when all the PagedLOD examined have left the view.
+        void advance(uint64_t frameCount);
+
+        /// begin a request, blocking until it's the highest priority waiting request and a slot is free. Return false if the request became stale and should be abandoned.
+        bool begin(uint64_t key);
+
+        /// check whether an active request should proceed to stage, return false if it's stale and should be abandoned, in which case end(key, false) must still be called.
+        bool proceed(uint64_t key, Stage stage);
+
+        /// end a request begun with begin(..), freeing it's slot for the next waiting request.
+        void end(uint64_t key, bool completed);
+
+        struct Metrics
+        {
+            uint64_t numRequests = 0;
+            uint64_t numCompleted = 0;
+            uint64_t numCancelled[NUM_STAGES] = {}; // number of requests cancelled before each stage
+            uint64_t numUntracked = 0;              // requests without a tracked PagedLOD, which are always admitted
+            size_t numWaiting = 0;                  // current backlog of requests waiting to be admitted
+            size_t maxWaiting = 0;                  // largest backlog seen
+            double wastedTime = 0.0;                // milliseconds spent on requests that were admitted and later cancelled
+        };
+
+        Metrics getMetrics() const;
+
+    protected:
+        virtual ~TileRequestScheduler();
+
+        struct Request
+        {
+            uint64_t key = 0;
+            vsg::ref_ptr<vsg::PagedLOD> plod;
+            std::chrono::steady_clock::time_point startTime;
+        };
+
+        bool _stale(const vsg::PagedLOD* plod);
+        bool _highestPriority(uint64_t id, const Request& request) const;
+        vsg::ref_ptr<vsg::PagedLOD> _find(uint64_t key) const;
+
+        mutable std::mutex _mutex;
+        std::condition_variable _condition;
+        std::unordered_map<uint64_t, vsg::observer_ptr<vsg::PagedLOD>> _tracked;
+        // the same tile may be requested by more than one thread, so waiting requests are held by the id of each call to begin(..) and active requests can share a key
+        std::map<uint64_t, Request> _waiting;
+        std::unordered_multimap<uint64_t, Request> _active;
+        uint64_t _nextRequestId = 0;
+        uint64_t _frameCount = 0;
+        uint32_t _numTrackedSincePrune = 0;
+        Metrics _metrics;
+    };
+
+} // namespace vsgGIS
+
+EVSG_type_name(vsgGIS::TileRequestScheduler);
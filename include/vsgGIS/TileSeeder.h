@@ -0,0 +1,80 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsgGIS/TileDatabase.h>
+
+#include <atomic>
+#include <functional>
+
+namespace vsgGIS
+{
+
+    /// TileSeeder fetches and decodes the tiles of a TileDatabase's layers over a region ahead of use, writing them out to a persistent store:
+    /// either a TileArchive, when the output filename has the TileArchive::fileExtension, or a directory of native .vsgb files laid out as {z}/{x}/{y}.vsgb.
+    /// Both preserve the meta data, such as the "offset" and "scale" of quantized terrain, needed to interpret the tiles.
+    class VSGGIS_DECLSPEC TileSeeder : public vsg::Inherit<vsg::Object, TileSeeder>
+    {
+    public:
+        explicit TileSeeder(vsg::ref_ptr<TileDatabaseSettings> in_settings);
+
+        vsg::ref_ptr<TileDatabaseSettings> settings;
+
+        /// number of threads fetching and decoding tiles, 0 uses the number of hardware threads.
+        uint32_t numThreads = 0;
+
+        /// interval in seconds between calls to the progress callback.
+        double progressInterval = 1.0;
+
+        struct Progress
+        {
+            size_t numTiles = 0;     // number of tiles to seed
+            size_t numCompleted = 0; // number of tiles fetched, including those that failed
+            size_t numFailed = 0;    // number of tiles that couldn't be fetched or written
+            uint64_t numBytes = 0;   // decoded size of the tiles fetched
+            double elapsedTime = 0.0; // seconds since seeding started
+
+            double tilesPerSecond() const { return elapsedTime > 0.0 ? double(numCompleted) / elapsedTime : 0.0; }
+            double bytesPerSecond() const { return elapsedTime > 0.0 ? double(numBytes) / elapsedTime : 0.0; }
+        };
+
+        /// called periodically from the seeding thread, and once on completion.
+        std::function<void(const Progress&)> progressCallback;
+
+        /// return the tileKey(x, y, level) of the tiles between minLevel and maxLevel inclusive whose extents intersect the polygon, specified as latitude, longitude vertices.
+        std::vector<uint64_t> computeTiles(const std::vector<vsg::dvec2>& latitudeLongitudePolygon, uint32_t minLevel, uint32_t maxLevel) const;
+
+        /// return the tileKey(x, y, level) of the tiles between minLevel and maxLevel inclusive that intersect the latitude, longitude bounding box.
+        std::vector<uint64_t> computeTiles(double minLatitude, double minLongitude, double maxLatitude, double maxLongitude, uint32_t minLevel, uint32_t maxLevel) const;
+
+        /// fetch the tiles of layer, writing them out to output. TileArchive output is written as the tiles complete, in tileKey order, so only a small window of tiles is held in memory. Return the final progress, with numFailed > 0 if any tiles couldn't be seeded.
+        Progress seed(const std::vector<uint64_t>& tiles, const vsg::Path& layer, const vsg::Path& output, vsg::ref_ptr<const vsg::Options> options = {});
+
+    protected:
+        virtual ~TileSeeder();
+    };
+
+} // namespace vsgGIS
+
+EVSG_type_name(vsgGIS::TileSeeder);
@@ -28,12 +28,18 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "gdal_priv.h"
 #include "ogr_spatialref.h"
 
+#include <vsg/core/Array2D.h>
 #include <vsg/core/Data.h>
+#include <vsg/core/Value.h>
 #include <vsg/maths/vec4.h>
 #include <vsg/io/Path.h>
 
+#include <cmath>
+#include <limits>
 #include <memory>
 #include <set>
+#include <type_traits>
+#include <vector>
 
 namespace vsgGIS
 {
@@ -54,17 +60,204 @@ namespace vsgGIS
         return std::shared_ptr<GDALDataset>(static_cast<GDALDataset*>(GDALOpenShared(filename.string().c_str(), access)), [](GDALDataset* dataset) { GDALClose(dataset); });
     }
 
-    /// return true if two GDALDataset has the same projection referecne string/
+    /// return true if two GDALDataset has the same projection, either the same projection reference string or equivalent OGRSpatialReference.
     extern VSGGIS_DECLSPEC bool compatibleDatasetProjections(const GDALDataset& lhs, const GDALDataset& rhs);
 
     /// return true if two GDALDataset has the same projection, geo transform and dimensions indicating they are perfectly pixel aliged and matched in size.
     extern VSGGIS_DECLSPEC bool compatibleDatasetProjectionsTransformAndSizes(const GDALDataset& lhs, const GDALDataset& rhs);
 
+    /// return the VkFormat used to store N components of type T in a vsg::Image2D.
+    template<typename T, int N>
+    constexpr VkFormat rasterFormat()
+    {
+        static_assert(N >= 1 && N <= 4, "rasterFormat() supports 1 to 4 components.");
+
+        if constexpr (std::is_same_v<T, uint8_t>)
+        {
+            constexpr VkFormat formats[] = {VK_FORMAT_R8_UNORM, VK_FORMAT_R8G8_UNORM, VK_FORMAT_R8G8B8_UNORM, VK_FORMAT_R8G8B8A8_UNORM};
+            return formats[N - 1];
+        }
+        else if constexpr (std::is_same_v<T, uint16_t>)
+        {
+            constexpr VkFormat formats[] = {VK_FORMAT_R16_UNORM, VK_FORMAT_R16G16_UNORM, VK_FORMAT_R16G16B16_UNORM, VK_FORMAT_R16G16B16A16_UNORM};
+            return formats[N - 1];
+        }
+        else if constexpr (std::is_same_v<T, int16_t>)
+        {
+            constexpr VkFormat formats[] = {VK_FORMAT_R16_SNORM, VK_FORMAT_R16G16_SNORM, VK_FORMAT_R16G16B16_SNORM, VK_FORMAT_R16G16B16A16_SNORM};
+            return formats[N - 1];
+        }
+        else if constexpr (std::is_same_v<T, uint32_t>)
+        {
+            constexpr VkFormat formats[] = {VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT};
+            return formats[N - 1];
+        }
+        else if constexpr (std::is_same_v<T, int32_t>)
+        {
+            constexpr VkFormat formats[] = {VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT};
+            return formats[N - 1];
+        }
+        else if constexpr (std::is_same_v<T, float>)
+        {
+            constexpr VkFormat formats[] = {VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT};
+            return formats[N - 1];
+        }
+        else if constexpr (std::is_same_v<T, double>)
+        {
+            constexpr VkFormat formats[] = {VK_FORMAT_R64_SFLOAT, VK_FORMAT_R64G64_SFLOAT, VK_FORMAT_R64G64B64_SFLOAT, VK_FORMAT_R64G64B64A64_SFLOAT};
+            return formats[N - 1];
+        }
+        else
+        {
+            return VK_FORMAT_UNDEFINED;
+        }
+    }
+
+    /// compile time description of the vsg::Data used to store raster data with N components of type T.
+    template<typename T, int N>
+    struct RasterType
+    {
+        using component_type = T;
+        using value_type = std::conditional_t<N == 1, T, std::conditional_t<N == 2, vsg::t_vec2<T>, std::conditional_t<N == 3, vsg::t_vec3<T>, vsg::t_vec4<T>>>>;
+        using array_type = vsg::Array2D<value_type>;
+
+        static constexpr int numComponents = N;
+        static constexpr VkFormat format = rasterFormat<T, N>();
+    };
+
+    /// call f(T{}) with the C++ type T used to store the specified GDALDataType, so the type is resolved once and f is instantiated for each type.
+    /// Returns the result of f, or a default constructed result for unsupported GDALDataType.
+    template<typename F>
+    auto dispatchDataType(GDALDataType dataType, F&& f) -> decltype(f(uint8_t{}))
+    {
+        using R = decltype(f(uint8_t{}));
+        switch (dataType)
+        {
+        case (GDT_Byte): return f(uint8_t{});
+        case (GDT_UInt16): return f(uint16_t{});
+        case (GDT_Int16): return f(int16_t{});
+        case (GDT_UInt32): return f(uint32_t{});
+        case (GDT_Int32): return f(int32_t{});
+        case (GDT_Float32): return f(float{});
+        case (GDT_Float64): return f(double{});
+        default: return R();
+        }
+    }
+
+    /// return true if value can be converted to T without changing it, so a band's NoData value that it's data type can't hold, such as -9999 on a Byte band, can be ignored rather than cast with undefined behaviour.
+    template<typename T>
+    bool isRepresentable(double value)
+    {
+        if constexpr (std::is_floating_point_v<T>)
+            return !std::isfinite(value) || std::abs(value) <= static_cast<double>(std::numeric_limits<T>::max());
+        else
+            return value >= static_cast<double>(std::numeric_limits<T>::lowest()) && value < std::ldexp(1.0, std::numeric_limits<T>::digits) && std::floor(value) == value;
+    }
+
+    /// call f(RasterType<T, N>{}) with the RasterType that maps to the specified GDALDataType and number of components.
+    /// Returns the result of f, or a default constructed result for unsupported combinations.
+    template<typename F>
+    auto dispatchRasterType(GDALDataType dataType, int numComponents, F&& f) -> decltype(f(RasterType<uint8_t, 1>{}))
+    {
+        using R = decltype(f(RasterType<uint8_t, 1>{}));
+        return dispatchDataType(dataType, [&](auto value) -> R {
+            using T = decltype(value);
+            switch (numComponents)
+            {
+            case (1): return f(RasterType<T, 1>{});
+            case (2): return f(RasterType<T, 2>{});
+            case (3): return f(RasterType<T, 3>{});
+            case (4): return f(RasterType<T, 4>{});
+            default: return R();
+            }
+        });
+    }
+
+    /// call f(RasterType<T, N>{}) with the RasterType whose VkFormat matches the specified format, f must return a default constructible type.
+    /// Returns the result of f, or a default constructed result for formats that don't map to a RasterType.
+    template<typename F>
+    auto dispatchImageFormat(VkFormat format, F&& f) -> decltype(f(RasterType<uint8_t, 1>{}))
+    {
+        using R = decltype(f(RasterType<uint8_t, 1>{}));
+        for (auto dataType : {GDT_Byte, GDT_UInt16, GDT_Int16, GDT_UInt32, GDT_Int32, GDT_Float32, GDT_Float64})
+        {
+            for (int numComponents = 1; numComponents <= 4; ++numComponents)
+            {
+                bool matched = false;
+                R result{};
+                dispatchRasterType(dataType, numComponents, [&](auto rasterType) {
+                    if (decltype(rasterType)::format != format) return;
+                    matched = true;
+                    result = f(rasterType);
+                });
+                if (matched) return result;
+            }
+        }
+        return R();
+    }
+
     /// create a vsg::Image2D of the approrpiate type that maps to specified dimensions and GDALDataType
     extern VSGGIS_DECLSPEC vsg::ref_ptr<vsg::Data> createImage2D(int width, int height, int numComponents, GDALDataType dataType, vsg::dvec4 def = {0.0, 0.0, 0.0, 1.0});
 
+    /// coverage of a block of raster data.
+    enum BlockCoverage : uint8_t
+    {
+        BLOCK_EMPTY = 0,   // block holds no data, either it's not stored in a sparse file or all it's values are NoData
+        BLOCK_PARTIAL = 1, // block holds a mix of NoData and valid values
+        BLOCK_FULL = 2     // block holds only valid values
+    };
+
+    /// per block coverage of a RasterBand, recorded by copyRasterBandToImage(..), so that tilers and TileReader can skip regions without data.
+    struct VSGGIS_DECLSPEC RasterCoverage
+    {
+        int blockWidth = 0;
+        int blockHeight = 0;
+        int numBlocksX = 0;
+        int numBlocksY = 0;
+        std::vector<uint8_t> blocks; // BlockCoverage of each block, row by row
+
+        /// return true if all blocks are BLOCK_EMPTY.
+        bool empty() const;
+
+        /// return the number of blocks with the specified coverage.
+        size_t count(BlockCoverage coverage) const;
+
+        /// merge the coverage of another band of the same dimensions, a block is only empty if it's empty in both.
+        void merge(const RasterCoverage& rhs);
+
+        /// create a VK_FORMAT_R8_UINT vsg::ubyteArray2D of the BlockCoverage values, with the block dimensions assigned as "blockWidth" and "blockHeight" values.
+        vsg::ref_ptr<vsg::ubyteArray2D> createData() const;
+    };
+
     /// copy a RasterBand onto a target RGBA component of a vsg::Data.  Dimensions and datatypes must be compatble between RasterBand and vsg::Data. Return true on success, false on failure to copy.
-    extern VSGGIS_DECLSPEC bool copyRasterBandToImage(GDALRasterBand& band, vsg::Data& image, int component);
+    /// Blocks that GDALRasterBand::GetDataCoverageStatus(..) reports as empty aren't read, the component is filled with the band's NoData value, or 0 if it has none, just as GDAL does when reading them.
+    /// When the band has a NoData value it is assigned to the image as setValue("NoDataValue", value), and if coverage is non null it is filled in with the coverage of each block.
+    extern VSGGIS_DECLSPEC bool copyRasterBandToImage(GDALRasterBand& band, vsg::Data& image, int component, RasterCoverage* coverage = nullptr);
+
+    /// mark a vsg::Data as holding only NoData values so tilers and TileReader can skip creating tiles for it.
+    inline void setNoDataOnly(vsg::Object& object, bool noDataOnly) { object.setValue("NoDataOnly", noDataOnly); }
+
+    /// return true if a vsg::Data has been marked with setNoDataOnly(..) as holding only NoData values.
+    inline bool isNoDataOnly(const vsg::Object& object)
+    {
+        bool noDataOnly = false;
+        return object.getValue("NoDataOnly", noDataOnly) && noDataOnly;
+    }
+
+    /// resampling methods used when reading a RasterBand window at a different resolution to the source data.
+    enum ResampleMethod
+    {
+        RESAMPLE_NEAREST,
+        RESAMPLE_AVERAGE,
+        RESAMPLE_BILINEAR
+    };
+
+    /// return the overview of band, or band itself, that has the lowest resolution that still provides at least the resolution required to sample a (xSize, ySize) window of band at (width, height).
+    extern VSGGIS_DECLSPEC GDALRasterBand* selectOverview(GDALRasterBand& band, int xSize, int ySize, int width, int height);
+
+    /// read the (xOff, yOff, xSize, ySize) window of a RasterBand, specified in full resolution pixels, resampled to the dimensions of the vsg::Data and copy onto a target RGBA component of it.
+    /// Overviews of the band are used when available so only the blocks required for the output resolution are read. Return true on success, false on failure to read.
+    extern VSGGIS_DECLSPEC bool readRasterBandWindowToImage(GDALRasterBand& band, int xOff, int yOff, int xSize, int ySize, vsg::Data& image, int component, ResampleMethod method = RESAMPLE_NEAREST);
 
     /// assign GDAL MetaData mapping the "key=value" entries to vsg::Object as setValue(key, std::string(value)).
     extern VSGGIS_DECLSPEC bool assignMetaData(GDALDataset& dataset, vsg::Object& object);
@@ -0,0 +1,75 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsgGIS/Export.h>
+
+#include <vsg/core/Data.h>
+#include <vsg/io/Options.h>
+
+#include <streambuf>
+
+namespace vsgGIS
+{
+
+    /// read only std::streambuf over a block of memory, used to decode files held in memory in place.
+    struct memory_streambuf : public std::streambuf
+    {
+        memory_streambuf(const uint8_t* ptr, size_t size)
+        {
+            auto begin = reinterpret_cast<char*>(const_cast<uint8_t*>(ptr));
+            setg(begin, begin, begin + size);
+        }
+
+        pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override
+        {
+            if ((which & std::ios_base::in) == 0) return pos_type(off_type(-1));
+
+            char* pos = nullptr;
+            if (dir == std::ios_base::beg)
+                pos = eback() + off;
+            else if (dir == std::ios_base::cur)
+                pos = gptr() + off;
+            else
+                pos = egptr() + off;
+
+            if (pos < eback() || pos > egptr()) return pos_type(off_type(-1));
+
+            setg(eback(), pos, egptr());
+            return pos_type(pos - eback());
+        }
+
+        pos_type seekpos(pos_type pos, std::ios_base::openmode which) override
+        {
+            return seekoff(off_type(pos), std::ios_base::beg, which);
+        }
+    };
+
+    /// return true if a ReaderWriter assigned to options, or vsg's native ReaderWriter, can read files with extension from a std::istream, which decodeData(..) requires.
+    extern VSGGIS_DECLSPEC bool canDecodeData(const vsg::Path& extension, vsg::ref_ptr<const vsg::Options> options = {});
+
+    /// decode the contents of a file held in memory, such as a .png or .jpg, using the ReaderWriter that supports extension, which includes the leading '.'.
+    extern VSGGIS_DECLSPEC vsg::ref_ptr<vsg::Data> decodeData(const uint8_t* ptr, size_t size, const vsg::Path& extension, vsg::ref_ptr<const vsg::Options> options = {});
+
+} // namespace vsgGIS
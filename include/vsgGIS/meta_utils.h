@@ -30,6 +30,17 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 namespace vsgGIS
 {
 
+    /// parse a number, optionally enclosed in brackets as used by GDAL's EXIF meta data, skipping leading spaces. Uses the classic locale and doesn't allocate.
+    /// Return a pointer to the character following the number, or nullptr if no number could be parsed.
+    extern VSGGIS_DECLSPEC const char* parseNumber(const char* str, double& value);
+
+    /// parse decimal degrees in the form of (degrees) (minutes) (seconds) as used with EXIF_GPSLatitude and EXIF_GPSLongitude tags, minutes and seconds are optional. Uses the classic locale and doesn't allocate.
+    /// Return a pointer to the character following the parsed values, or nullptr if no degrees value could be parsed.
+    extern VSGGIS_DECLSPEC const char* parseDMS(const char* str, double& value);
+
+    /// get the latitude, longitude and altitude values from the EXIF_GPSLatitude, EXIF_GPSLongitude and EXIF_GPSAltitude entries of a GDAL meta data list, with EXIF_GPSLatitudeRef and EXIF_GPSLongitudeRef applied. Return true on success.
+    extern VSGGIS_DECLSPEC bool getEXIF_LatitudeLongitudeAlititude(char** metaData, double& latitude, double& longitude, double& altitude);
+
     /// get the latitude, longitude and altitude values from the GDALDataSet's EXIF_GPSLatitude, EXIF_GPSLongitude and EXIF_GPSAltitude meta data fields, return true on success,
     extern VSGGIS_DECLSPEC bool getEXIF_LatitudeLongitudeAlititude(GDALDataset& dataset, double& latitude, double& longitude, double& altitude);
 
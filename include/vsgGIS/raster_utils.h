@@ -0,0 +1,163 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsgGIS/gdal_utils.h>
+
+#include <cstring>
+#include <limits>
+
+namespace vsgGIS
+{
+
+    /// range of values held in a raster, an invalid range has minimum > maximum.
+    struct ValueRange
+    {
+        double minimum = std::numeric_limits<double>::max();
+        double maximum = std::numeric_limits<double>::lowest();
+
+        bool valid() const { return minimum <= maximum; }
+
+        void expandBy(const ValueRange& rhs)
+        {
+            if (rhs.minimum < minimum) minimum = rhs.minimum;
+            if (rhs.maximum > maximum) maximum = rhs.maximum;
+        }
+    };
+
+    /// compute the range of values of a component of a vsg::Data, NaN values and values equal to noDataValue, when one is provided, are skipped.
+    /// Large images are split into row ranges that are reduced in parallel.
+    extern VSGGIS_DECLSPEC ValueRange computeValueRange(const vsg::Data& data, int component = 0, const double* noDataValue = nullptr);
+
+    /// compute the range of values of a whole RasterBand, for use as a per dataset range, approximate uses overviews or a subset of blocks when available.
+    extern VSGGIS_DECLSPEC ValueRange computeValueRange(GDALRasterBand& band, bool approximate = false);
+
+    /// convert a 32bit float to an IEEE 754 half float, rounding to nearest even.
+    inline uint16_t floatToHalf(float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+
+        uint32_t sign = (bits >> 16) & 0x8000u;
+        uint32_t exponent = (bits >> 23) & 0xffu;
+        uint32_t mantissa = bits & 0x7fffffu;
+
+        // NaN and Inf
+        if (exponent == 0xffu) return static_cast<uint16_t>(sign | 0x7c00u | (mantissa ? 0x200u : 0u));
+
+        int32_t halfExponent = static_cast<int32_t>(exponent) - 127 + 15;
+
+        // overflow to Inf
+        if (halfExponent >= 0x1f) return static_cast<uint16_t>(sign | 0x7c00u);
+
+        if (halfExponent <= 0)
+        {
+            // too small for a denormalized half so flush to signed zero
+            if (halfExponent < -10) return static_cast<uint16_t>(sign);
+
+            // denormalized half
+            mantissa |= 0x800000u;
+            uint32_t shift = static_cast<uint32_t>(14 - halfExponent);
+            uint32_t halfMantissa = mantissa >> shift;
+            uint32_t remainder = mantissa & ((1u << shift) - 1u);
+            uint32_t halfway = 1u << (shift - 1u);
+            if (remainder > halfway || (remainder == halfway && (halfMantissa & 1u))) ++halfMantissa;
+            return static_cast<uint16_t>(sign | halfMantissa);
+        }
+
+        uint32_t half = sign | (static_cast<uint32_t>(halfExponent) << 10) | (mantissa >> 13);
+        uint32_t remainder = mantissa & 0x1fffu;
+
+        // round to nearest even, a carry into the exponent correctly rounds up to the next power of two or Inf
+        if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u))) ++half;
+        return static_cast<uint16_t>(half);
+    }
+
+    /// convert an IEEE 754 half float to a 32bit float.
+    inline float halfToFloat(uint16_t value)
+    {
+        uint32_t sign = static_cast<uint32_t>(value & 0x8000u) << 16;
+        uint32_t exponent = (value >> 10) & 0x1fu;
+        uint32_t mantissa = value & 0x3ffu;
+
+        uint32_t bits;
+        if (exponent == 0)
+        {
+            if (mantissa == 0)
+            {
+                bits = sign;
+            }
+            else
+            {
+                // normalize the denormalized half
+                exponent = 127 - 15 + 1;
+                while ((mantissa & 0x400u) == 0)
+                {
+                    mantissa <<= 1;
+                    --exponent;
+                }
+                bits = sign | (exponent << 23) | ((mantissa & 0x3ffu) << 13);
+            }
+        }
+        else if (exponent == 0x1f)
+        {
+            bits = sign | 0x7f800000u | (mantissa << 13);
+        }
+        else
+        {
+            bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+        }
+
+        float result;
+        std::memcpy(&result, &bits, sizeof(result));
+        return result;
+    }
+
+    /// convert a component of a vsg::Data to a single component VK_FORMAT_R16_SFLOAT image, subtracting offset from each value to make best use of the half float precision. When noDataValue is provided it is mapped to NaN.
+    /// The offset is stored on the returned data as setValue("offset", offset) and setValue("scale", 1.0) so that value = offset + scale * sample.
+    extern VSGGIS_DECLSPEC vsg::ref_ptr<vsg::Data> convertToHalfFloat(const vsg::Data& data, int component = 0, double offset = 0.0, const double* noDataValue = nullptr);
+
+    /// quantize a component of a vsg::Data to a single component VK_FORMAT_R16_UNORM image mapping range onto 0 to 1. When noDataValue is provided it is mapped to 0 and valid values are mapped to 1 to 65535.
+    /// The mapping is stored on the returned data as setValue("offset", offset) and setValue("scale", scale) so that value = offset + scale * sample, where sample is the normalized 0 to 1 value read by the GPU.
+    /// When noDataValue is provided the reserved raw sample is stored as setValue("NoDataSample", 0.0), raw samples equal to it must be treated as NoData rather than decoded.
+    extern VSGGIS_DECLSPEC vsg::ref_ptr<vsg::Data> quantizeToUNorm16(const vsg::Data& data, const ValueRange& range, int component = 0, const double* noDataValue = nullptr);
+
+    /// methods of combining the colour of an image layer with the colour of the layers below it.
+    enum BlendMode : uint32_t
+    {
+        BLEND_NORMAL,   // layer colour
+        BLEND_MULTIPLY, // layer colour * colour below
+        BLEND_SCREEN,   // layer colour + colour below - layer colour * colour below
+        BLEND_ADD       // layer colour + colour below, clamped to 1
+    };
+
+    /// create a copy of an 8 bit RGB, RGBA, BGR or BGRA image as a 4 component image that layers can be composited onto with compositeImage(..), 3 component images are given an opaque alpha.
+    /// Returns null ref_ptr<> for other formats, including block compressed formats.
+    extern VSGGIS_DECLSPEC vsg::ref_ptr<vsg::Data> createCompositeImage(const vsg::Data& image);
+
+    /// composite source over the 4 component 8 bit destination, weighting the blended colour by the source alpha multiplied by opacity. The source may be any 8 bit RGB, RGBA, BGR or BGRA image,
+    /// images of a different size or origin are resampled to the destination with nearest neighbour sampling. Returns false if either format isn't supported, leaving destination unchanged.
+    extern VSGGIS_DECLSPEC bool compositeImage(vsg::Data& destination, const vsg::Data& source, float opacity = 1.0f, BlendMode blendMode = BLEND_NORMAL);
+
+} // namespace vsgGIS
@@ -0,0 +1,308 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsgGIS/AsyncFileReader.h>
+
+#include <vsg/io/Logger.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <fstream>
+
+#if !defined(_WIN32)
+#    include <fcntl.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+#if defined(VSGGIS_HAS_IO_URING)
+#    include <liburing.h>
+#endif
+
+using namespace vsgGIS;
+
+struct AsyncFileReader::Ring
+{
+#if defined(VSGGIS_HAS_IO_URING)
+    io_uring ring;
+#endif
+};
+
+namespace
+{
+#if !defined(_WIN32)
+    struct FileRead
+    {
+        int fd = -1;
+        vsg::ref_ptr<vsg::ubyteArray> buffer;
+        size_t offset = 0;
+
+        size_t remaining() const { return buffer->dataSize() - offset; }
+    };
+
+    // read the remainder of file with pread(), return false on error
+    bool readRemaining(FileRead& file)
+    {
+        while (file.remaining() > 0)
+        {
+            auto result = ::pread(file.fd, file.buffer->data() + file.offset, file.remaining(), static_cast<off_t>(file.offset));
+            if (result <= 0) return false;
+            file.offset += static_cast<size_t>(result);
+        }
+        return true;
+    }
+#endif
+} // namespace
+
+AsyncFileReader::AsyncFileReader(uint32_t in_queueDepth) :
+    queueDepth(std::max(1u, in_queueDepth))
+{
+#if defined(VSGGIS_HAS_IO_URING)
+    // check that the kernel supports io_uring, as it may be disabled or unavailable in containers
+    if (auto ring = _acquireRing())
+    {
+        _usingIOUring = true;
+        _releaseRing(ring);
+    }
+    else
+    {
+        vsg::info("AsyncFileReader io_uring not available, falling back to pread().");
+    }
+#endif
+}
+
+AsyncFileReader::~AsyncFileReader()
+{
+    for (auto ring : _availableRings)
+    {
+#if defined(VSGGIS_HAS_IO_URING)
+        io_uring_queue_exit(&ring->ring);
+#endif
+        delete ring;
+    }
+}
+
+AsyncFileReader::Ring* AsyncFileReader::_acquireRing()
+{
+#if defined(VSGGIS_HAS_IO_URING)
+    {
+        std::scoped_lock<std::mutex> lock(_mutex);
+        if (!_availableRings.empty())
+        {
+            auto ring = _availableRings.back();
+            _availableRings.pop_back();
+            return ring;
+        }
+    }
+
+    auto ring = new Ring;
+    if (io_uring_queue_init(queueDepth, &ring->ring, 0) < 0)
+    {
+        delete ring;
+        return nullptr;
+    }
+    return ring;
+#else
+    return nullptr;
+#endif
+}
+
+void AsyncFileReader::_releaseRing(Ring* ring)
+{
+    std::scoped_lock<std::mutex> lock(_mutex);
+    _availableRings.push_back(ring);
+}
+
+std::vector<vsg::ref_ptr<vsg::ubyteArray>> AsyncFileReader::read(const vsg::Paths& filenames)
+{
+    std::vector<vsg::ref_ptr<vsg::ubyteArray>> results(filenames.size());
+
+#if defined(_WIN32)
+    for (size_t i = 0; i < filenames.size(); ++i)
+    {
+        std::ifstream fin(filenames[i].string(), std::ios::in | std::ios::binary | std::ios::ate);
+        if (!fin) continue;
+
+        size_t fileSize = static_cast<size_t>(fin.tellg());
+        if (fileSize == 0) continue;
+
+        auto buffer = vsg::ubyteArray::create(fileSize);
+        fin.seekg(0);
+        fin.read(reinterpret_cast<char*>(buffer->data()), fileSize);
+        if (fin) results[i] = buffer;
+    }
+#else
+    // open all the files and allocate their buffers up front so all the reads can be submitted together
+    std::vector<FileRead> files(filenames.size());
+    for (size_t i = 0; i < filenames.size(); ++i)
+    {
+        int fd = ::open(filenames[i].string().c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) continue;
+
+        struct stat fileStat;
+        if (fstat(fd, &fileStat) != 0 || fileStat.st_size <= 0)
+        {
+            ::close(fd);
+            continue;
+        }
+
+        files[i].fd = fd;
+        files[i].buffer = vsg::ubyteArray::create(static_cast<size_t>(fileStat.st_size));
+    }
+
+    std::vector<bool> failed(files.size(), false);
+
+    Ring* ring = _usingIOUring ? _acquireRing() : nullptr;
+    if (ring)
+    {
+#    if defined(VSGGIS_HAS_IO_URING)
+        // keep up to queueDepth reads in flight, resubmitting the remainder of short reads
+        size_t next = 0;
+        uint32_t inFlight = 0;
+        std::vector<bool> pending(files.size(), false);
+        bool ringFailed = false;
+        bool submitFailed = false;
+        std::vector<size_t> queued;
+        auto submitNext = [&]() {
+            if (submitFailed) return;
+
+            queued.clear();
+            while (inFlight < queueDepth)
+            {
+                while (next < files.size() && files[next].fd < 0) ++next;
+                if (next >= files.size()) break;
+
+                auto sqe = io_uring_get_sqe(&ring->ring);
+                if (!sqe) break;
+
+                auto& file = files[next];
+                io_uring_prep_read(sqe, file.fd, file.buffer->data() + file.offset, static_cast<unsigned>(file.remaining()), file.offset);
+                io_uring_sqe_set_data(sqe, reinterpret_cast<void*>(next));
+                pending[next] = true;
+                queued.push_back(next);
+                ++inFlight;
+                ++next;
+            }
+            if (queued.empty()) return;
+
+            int submitted = io_uring_submit(&ring->ring);
+            if (submitted >= static_cast<int>(queued.size())) return;
+
+            // the reads that weren't submitted won't complete, so stop using the ring and leave them to be completed with pread()
+            vsg::warn("AsyncFileReader::read() io_uring_submit() submitted ", std::max(submitted, 0), " of ", queued.size(), " reads, error ", submitted < 0 ? -submitted : 0);
+            submitFailed = true;
+            for (size_t i = static_cast<size_t>(std::max(submitted, 0)); i < queued.size(); ++i)
+            {
+                pending[queued[i]] = false;
+                --inFlight;
+            }
+        };
+
+        submitNext();
+        while (inFlight > 0)
+        {
+            io_uring_cqe* cqe = nullptr;
+            int status = io_uring_wait_cqe(&ring->ring, &cqe);
+            if (status == -EINTR) continue;
+            if (status < 0)
+            {
+                vsg::warn("AsyncFileReader::read() io_uring_wait_cqe() failed, error ", -status);
+                std::fill(failed.begin(), failed.end(), true);
+                ringFailed = true;
+                break;
+            }
+
+            size_t index = reinterpret_cast<size_t>(io_uring_cqe_get_data(cqe));
+            int result = cqe->res;
+            io_uring_cqe_seen(&ring->ring, cqe);
+            pending[index] = false;
+            --inFlight;
+
+            auto& file = files[index];
+            if (result <= 0)
+            {
+                failed[index] = true;
+            }
+            else
+            {
+                file.offset += static_cast<size_t>(result);
+
+                // a short read is completed synchronously rather than requeued, which is rare for regular files
+                if (file.remaining() > 0 && !readRemaining(file)) failed[index] = true;
+            }
+
+            submitNext();
+        }
+
+        if (ringFailed)
+        {
+            // the kernel may still complete the reads in flight, writing into their buffers, and their completions would be reaped by the next user of the ring.
+            // So the ring is torn down rather than reused, and the buffers of the reads in flight are deliberately leaked as there's no way of knowing when the kernel is done with them.
+            for (size_t i = 0; i < files.size(); ++i)
+            {
+                if (pending[i]) files[i].buffer->ref();
+            }
+
+            io_uring_queue_exit(&ring->ring);
+            delete ring;
+            ring = nullptr;
+        }
+        else
+        {
+            if (submitFailed)
+            {
+                // the unsubmitted entries are still in the submission queue, so tear down the ring rather than have the next user of the ring submit them
+                io_uring_queue_exit(&ring->ring);
+                delete ring;
+                ring = nullptr;
+            }
+
+            // complete any reads left unsubmitted because no submission queue entries were available, or io_uring_submit() failed
+            for (size_t i = 0; i < files.size(); ++i)
+            {
+                if (files[i].fd >= 0 && !failed[i] && files[i].remaining() > 0 && !readRemaining(files[i])) failed[i] = true;
+            }
+        }
+#    endif
+        if (ring) _releaseRing(ring);
+    }
+    else
+    {
+        for (size_t i = 0; i < files.size(); ++i)
+        {
+            if (files[i].fd >= 0 && !readRemaining(files[i])) failed[i] = true;
+        }
+    }
+
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+        auto& file = files[i];
+        if (file.fd < 0) continue;
+
+        ::close(file.fd);
+        if (!failed[i]) results[i] = file.buffer;
+    }
+#endif
+
+    return results;
+}
@@ -0,0 +1,113 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsgGIS/DatasetPool.h>
+
+using namespace vsgGIS;
+
+DatasetPool::DatasetPool(size_t maxOpenDatasets) :
+    _maxOpenDatasets(maxOpenDatasets)
+{
+}
+
+vsg::ref_ptr<DatasetPool>& DatasetPool::instance()
+{
+    static vsg::ref_ptr<DatasetPool> s_pool(new DatasetPool());
+    return s_pool;
+}
+
+std::shared_ptr<GDALDataset> DatasetPool::acquire(const vsg::Path& filename, GDALAccess access)
+{
+    Key key{filename.string(), std::this_thread::get_id(), access};
+
+    {
+        std::scoped_lock<std::mutex> lock(_mutex);
+
+        if (auto itr = _entries.find(key); itr != _entries.end())
+        {
+            _lru.splice(_lru.begin(), _lru, itr->second.lruPosition);
+            ++_stats.numReused;
+            return itr->second.dataset;
+        }
+    }
+
+    // open outside the lock so that parsing of file headers by different threads can run concurrently.
+    // Only the calling thread can insert an entry for this key so there is no race with another open of the same handle.
+    auto dataset = openDataSet(filename, access);
+
+    std::scoped_lock<std::mutex> lock(_mutex);
+
+    if (!dataset)
+    {
+        ++_stats.numFailed;
+        return {};
+    }
+
+    ++_stats.numOpened;
+
+    _lru.push_front(key);
+    _entries[key] = Entry{dataset, _lru.begin()};
+
+    _evict();
+
+    return dataset;
+}
+
+void DatasetPool::setMaxOpenDatasets(size_t maxOpenDatasets)
+{
+    std::scoped_lock<std::mutex> lock(_mutex);
+    _maxOpenDatasets = maxOpenDatasets;
+    _evict();
+}
+
+size_t DatasetPool::getMaxOpenDatasets() const
+{
+    std::scoped_lock<std::mutex> lock(_mutex);
+    return _maxOpenDatasets;
+}
+
+void DatasetPool::clear()
+{
+    std::scoped_lock<std::mutex> lock(_mutex);
+    _entries.clear();
+    _lru.clear();
+}
+
+DatasetPool::Stats DatasetPool::getStats() const
+{
+    std::scoped_lock<std::mutex> lock(_mutex);
+    Stats stats = _stats;
+    stats.numOpen = _entries.size();
+    return stats;
+}
+
+void DatasetPool::_evict()
+{
+    // caller must hold _mutex. Evicted handles that are still held by a caller are closed when they release them
+    while (_entries.size() > _maxOpenDatasets && !_lru.empty())
+    {
+        _entries.erase(_lru.back());
+        _lru.pop_back();
+        ++_stats.numEvicted;
+    }
+}
@@ -0,0 +1,175 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsgGIS/ElevationIndex.h>
+#include <vsgGIS/TileDatabase.h>
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+using namespace vsgGIS;
+
+namespace
+{
+    // number of tiles added between removing expired entries
+    constexpr uint32_t s_prunePeriod = 64;
+} // namespace
+
+ElevationIndex::ElevationIndex(vsg::ref_ptr<TileDatabaseSettings> in_settings) :
+    _settings(in_settings)
+{
+}
+
+ElevationIndex::~ElevationIndex()
+{
+}
+
+void ElevationIndex::add(uint32_t x, uint32_t y, uint32_t level, vsg::ref_ptr<const vsg::floatArray2D> heights, vsg::Node* tile)
+{
+    if (!heights || heights->width() < 2 || heights->height() < 2 || !tile) return;
+
+    Tile entry;
+    entry.heights = heights;
+    entry.extents = _settings->computeTileExtents(x, y, level);
+    entry.node = vsg::observer_ptr<vsg::Node>(tile);
+
+    std::unique_lock<std::shared_mutex> lock(_mutex);
+
+    _tiles[tileKey(x, y, level)] = std::move(entry);
+    _maxLevel = std::max(_maxLevel, level);
+
+    if (++_numAddedSincePrune >= s_prunePeriod) _prune();
+}
+
+void ElevationIndex::prune()
+{
+    std::unique_lock<std::shared_mutex> lock(_mutex);
+    _prune();
+}
+
+void ElevationIndex::_prune()
+{
+    _numAddedSincePrune = 0;
+    for (auto itr = _tiles.begin(); itr != _tiles.end();)
+    {
+        if (itr->second.node.valid())
+            ++itr;
+        else
+            itr = _tiles.erase(itr);
+    }
+}
+
+size_t ElevationIndex::size() const
+{
+    std::shared_lock<std::shared_mutex> lock(_mutex);
+    return _tiles.size();
+}
+
+ElevationIndex::Result ElevationIndex::query(double latitude, double longitude) const
+{
+    std::shared_lock<std::shared_mutex> lock(_mutex);
+    return _query(latitude, longitude);
+}
+
+void ElevationIndex::query(size_t count, const vsg::dvec2* latitudeLongitudes, Result* results) const
+{
+    // take the lock once for the whole batch
+    std::shared_lock<std::shared_mutex> lock(_mutex);
+    for (size_t i = 0; i < count; ++i)
+    {
+        results[i] = _query(latitudeLongitudes[i].x, latitudeLongitudes[i].y);
+    }
+}
+
+double ElevationIndex::_sample(const Tile& tile, double x, double y) const
+{
+    auto& heights = *tile.heights;
+    uint32_t numColumns = heights.width();
+    uint32_t numRows = heights.height();
+
+    double fx = (x - tile.extents.min.x) / (tile.extents.max.x - tile.extents.min.x) * double(numColumns - 1);
+    double fy = (y - tile.extents.min.y) / (tile.extents.max.y - tile.extents.min.y) * double(numRows - 1);
+
+    uint32_t c = static_cast<uint32_t>(std::clamp(std::floor(fx), 0.0, double(numColumns - 2)));
+    uint32_t r = static_cast<uint32_t>(std::clamp(std::floor(fy), 0.0, double(numRows - 2)));
+    double tx = std::clamp(fx - double(c), 0.0, 1.0);
+    double ty = std::clamp(fy - double(r), 0.0, 1.0);
+
+    double h00 = heights.at(c, r);
+    double h10 = heights.at(c + 1, r);
+    double h01 = heights.at(c, r + 1);
+    double h11 = heights.at(c + 1, r + 1);
+    return (h00 * (1.0 - tx) + h10 * tx) * (1.0 - ty) + (h01 * (1.0 - tx) + h11 * tx) * ty;
+}
+
+ElevationIndex::Result ElevationIndex::_query(double latitude, double longitude) const
+{
+    auto& ellipsoidModel = *_settings->ellipsoidModel;
+
+    Result result;
+    vsg::dvec3 location = _settings->computeTileLocation(vsg::dvec3(latitude, longitude, 0.0));
+
+    // descend the tile hierarchy from the root tiles, stopping at the first level that isn't resident
+    const Tile* tile = nullptr;
+    for (uint32_t level = 0; level <= _maxLevel; ++level)
+    {
+        uint32_t x, y;
+        if (!_settings->computeTileCoordinates(location, level, x, y)) break;
+
+        auto itr = _tiles.find(tileKey(x, y, level));
+        if (itr == _tiles.end() || !itr->second.node.valid()) break;
+
+        tile = &(itr->second);
+        result.level = level;
+    }
+
+    if (!tile)
+    {
+        // no resident tile so fall back to the ellipsoid surface
+        double cosLatitude = std::cos(vsg::radians(latitude));
+        result.position = ellipsoidModel.convertLatLongAltitudeToECEF(vsg::dvec3(latitude, longitude, 0.0));
+        result.normal.set(cosLatitude * std::cos(vsg::radians(longitude)), cosLatitude * std::sin(vsg::radians(longitude)), std::sin(vsg::radians(latitude)));
+        return result;
+    }
+
+    result.valid = true;
+    result.height = _sample(*tile, location.x, location.y);
+    result.position = ellipsoidModel.convertLatLongAltitudeToECEF(vsg::dvec3(latitude, longitude, result.height));
+
+    // compute the normal from the surface one grid spacing either side of the point
+    double dx = (tile->extents.max.x - tile->extents.min.x) / double(tile->heights->width() - 1);
+    double dy = (tile->extents.max.y - tile->extents.min.y) / double(tile->heights->height() - 1);
+    auto surfacePoint = [&](double x, double y) {
+        auto latitudeLongitudeAltitude = _settings->computeLatitudeLongitudeAltitude(vsg::dvec3(x, y, 0.0));
+        latitudeLongitudeAltitude.z = _sample(*tile, x, y);
+        return ellipsoidModel.convertLatLongAltitudeToECEF(latitudeLongitudeAltitude);
+    };
+
+    vsg::dvec3 east = surfacePoint(location.x + dx, location.y) - surfacePoint(location.x - dx, location.y);
+    vsg::dvec3 north = surfacePoint(location.x, location.y + dy) - surfacePoint(location.x, location.y - dy);
+    result.normal = vsg::normalize(vsg::cross(east, north));
+    if (vsg::dot(result.normal, result.position) < 0.0) result.normal = result.normal * -1.0;
+
+    return result;
+}
@@ -0,0 +1,335 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsgGIS/FetchCoalescer.h>
+#include <vsgGIS/io_utils.h>
+
+#include <vsg/io/FileSystem.h>
+#include <vsg/io/Logger.h>
+#include <vsg/threading/Latch.h>
+
+using namespace vsgGIS;
+
+namespace
+{
+    // decode a file held in memory on a worker thread, counting down the latch on completion
+    struct DecodeOperation : public vsg::Inherit<vsg::Operation, DecodeOperation>
+    {
+        DecodeOperation(vsg::ref_ptr<vsg::ubyteArray> in_buffer, const vsg::Path& in_extension, vsg::ref_ptr<const vsg::Options> in_options, vsg::ref_ptr<vsg::Object>& in_result, vsg::ref_ptr<vsg::Latch> in_latch) :
+            buffer(in_buffer),
+            extension(in_extension),
+            options(in_options),
+            result(in_result),
+            latch(in_latch) {}
+
+        vsg::ref_ptr<vsg::ubyteArray> buffer;
+        vsg::Path extension;
+        vsg::ref_ptr<const vsg::Options> options;
+        vsg::ref_ptr<vsg::Object>& result;
+        vsg::ref_ptr<vsg::Latch> latch;
+
+        void run() override
+        {
+            // a file that fails to decode is left to vsg::read(..), an exception escaping run() would terminate the worker thread's process
+            try
+            {
+                result = decodeData(buffer->data(), buffer->dataSize(), extension, options);
+            }
+            catch (const std::exception& e)
+            {
+                vsg::warn("FetchCoalescer DecodeOperation::run() exception decoding buffer: ", e.what());
+            }
+            latch->count_down();
+        }
+    };
+} // namespace
+
+FetchCoalescer::FetchCoalescer()
+{
+}
+
+FetchCoalescer::~FetchCoalescer()
+{
+}
+
+vsg::ref_ptr<FetchCoalescer>& FetchCoalescer::instance()
+{
+    static vsg::ref_ptr<FetchCoalescer> s_fetchCoalescer = []() {
+        auto fetchCoalescer = FetchCoalescer::create();
+
+        // batched reads only pay off when they're submitted asynchronously
+        auto fileReader = AsyncFileReader::create();
+        if (fileReader->usingIOUring()) fetchCoalescer->fileReader = fileReader;
+
+        return fetchCoalescer;
+    }();
+    return s_fetchCoalescer;
+}
+
+FetchCoalescer::Key FetchCoalescer::_key(const vsg::Path& path, const vsg::Options* options)
+{
+    // different Options can resolve the same path to different files, so share by the file when it's found
+    auto filename = vsg::findFile(path, options);
+    if (!filename.empty()) return Key(filename, nullptr);
+    return Key(path, options);
+}
+
+vsg::PathObjects FetchCoalescer::read(const vsg::Paths& paths, vsg::ref_ptr<const vsg::Options> options)
+{
+    vsg::PathObjects pathObjects;
+
+    // resolve the paths outside the lock as findFile(..) checks the file system
+    std::map<vsg::Path, Key> keys;
+    for (auto& path : paths)
+    {
+        if (keys.count(path) == 0) keys.emplace(path, _key(path, options.get()));
+    }
+
+    // split the paths into those this thread reads, those another thread is already reading and those already cached
+    vsg::Paths pathsToRead;
+    std::map<vsg::Path, std::promise<vsg::ref_ptr<vsg::Object>>> promises;
+    std::map<vsg::Path, Future> futures;
+    {
+        std::scoped_lock<std::mutex> lock(_mutex);
+
+        for (auto& path : paths)
+        {
+            if (pathObjects.count(path) > 0 || promises.count(path) > 0 || futures.count(path) > 0) continue;
+
+            ++_metrics.numRequested;
+
+            auto& key = keys[path];
+            if (auto lruItr = _lruIndex.find(key); lruItr != _lruIndex.end())
+            {
+                _lru.splice(_lru.begin(), _lru, lruItr->second);
+                pathObjects[path] = lruItr->second->second;
+                ++_metrics.numCacheHits;
+            }
+            else if (auto flightItr = _inFlight.find(key); flightItr != _inFlight.end())
+            {
+                futures[path] = flightItr->second;
+                ++_metrics.numCoalesced;
+            }
+            else
+            {
+                auto& promise = promises[path];
+                _inFlight[key] = promise.get_future().share();
+                pathsToRead.push_back(path);
+                ++_metrics.numRead;
+            }
+        }
+    }
+
+    if (!pathsToRead.empty())
+    {
+        vsg::PathObjects readObjects;
+        try
+        {
+            readObjects = _read(pathsToRead, options);
+        }
+        catch (...)
+        {
+            // pass the exception on to the waiting threads, and stop coalescing onto the failed reads so later requests read the files again
+            auto exception = std::current_exception();
+            std::scoped_lock<std::mutex> lock(_mutex);
+            for (auto& path : pathsToRead)
+            {
+                promises[path].set_exception(exception);
+                _inFlight.erase(keys[path]);
+            }
+            throw;
+        }
+
+        std::scoped_lock<std::mutex> lock(_mutex);
+
+        for (auto& path : pathsToRead)
+        {
+            auto itr = readObjects.find(path);
+            vsg::ref_ptr<vsg::Object> object;
+            if (itr != readObjects.end()) object = itr->second;
+
+            auto& key = keys[path];
+            if (auto data = object.cast<vsg::Data>()) _cache(key, data);
+
+            // release the waiting threads
+            promises[path].set_value(object);
+            _inFlight.erase(key);
+
+            pathObjects[path] = object;
+        }
+    }
+
+    // wait for the reads of other threads to complete
+    for (auto& [path, future] : futures)
+    {
+        pathObjects[path] = future.get();
+    }
+
+    return pathObjects;
+}
+
+vsg::PathObjects FetchCoalescer::_read(const vsg::Paths& paths, vsg::ref_ptr<const vsg::Options> options)
+{
+    if (!fileReader) return vsg::read(paths, options);
+
+    vsg::PathObjects pathObjects;
+
+    // read the local files that can be decoded from memory as a single batch, files such as GeoTIFFs that their ReaderWriter has to open itself are left to vsg::read(..) so they aren't read twice
+    vsg::Paths remotePaths;
+    vsg::Paths localPaths;
+    vsg::Paths filenames;
+    std::map<vsg::Path, bool> decodable;
+    for (auto& path : paths)
+    {
+        auto extension = vsg::lowerCaseFileExtension(path);
+        auto itr = decodable.find(extension);
+        if (itr == decodable.end()) itr = decodable.emplace(extension, canDecodeData(extension, options)).first;
+
+        auto filename = itr->second ? vsg::findFile(path, options) : vsg::Path();
+        if (filename.empty())
+        {
+            remotePaths.push_back(path);
+        }
+        else
+        {
+            localPaths.push_back(path);
+            filenames.push_back(filename);
+        }
+    }
+
+    auto buffers = fileReader->read(filenames);
+
+    // decode the buffers, concurrently when decodeThreads are available
+    std::vector<vsg::ref_ptr<vsg::Object>> objects(localPaths.size());
+    auto latch = vsg::Latch::create(0);
+    for (size_t i = 0; i < localPaths.size(); ++i)
+    {
+        if (!buffers[i]) continue;
+
+        auto extension = vsg::lowerCaseFileExtension(localPaths[i]);
+        if (decodeThreads)
+        {
+            latch->count_up();
+            decodeThreads->queue->add(DecodeOperation::create(buffers[i], extension, options, objects[i], latch));
+        }
+        else
+        {
+            objects[i] = decodeData(buffers[i]->data(), buffers[i]->dataSize(), extension, options);
+        }
+    }
+    latch->wait();
+
+    size_t numFileReads = 0;
+    for (size_t i = 0; i < localPaths.size(); ++i)
+    {
+        if (objects[i])
+        {
+            pathObjects[localPaths[i]] = objects[i];
+            ++numFileReads;
+        }
+        else
+        {
+            // not readable from memory so leave it to the ReaderWriter to open
+            remotePaths.push_back(localPaths[i]);
+        }
+    }
+
+    {
+        std::scoped_lock<std::mutex> lock(_mutex);
+        _metrics.numFileReads += numFileReads;
+    }
+
+    if (!remotePaths.empty())
+    {
+        for (auto& [path, object] : vsg::read(remotePaths, options)) pathObjects[path] = object;
+    }
+
+    return pathObjects;
+}
+
+void FetchCoalescer::_cache(const Key& key, vsg::ref_ptr<vsg::Data> data)
+{
+    if (maxCacheSize == 0) return;
+
+    size_t size = data->dataSize();
+    if (size > maxCacheSize) return;
+
+    if (auto itr = _lruIndex.find(key); itr != _lruIndex.end())
+    {
+        _metrics.cacheSize -= itr->second->second->dataSize();
+        _lru.erase(itr->second);
+        _lruIndex.erase(itr);
+    }
+
+    _lru.emplace_front(key, data);
+    _lruIndex[key] = _lru.begin();
+    _metrics.cacheSize += size;
+
+    _trim();
+}
+
+void FetchCoalescer::_trim()
+{
+    // evict the least recently used
+    while (_metrics.cacheSize > maxCacheSize && !_lru.empty())
+    {
+        auto& [lruKey, lruData] = _lru.back();
+        _metrics.cacheSize -= lruData->dataSize();
+        _lruIndex.erase(lruKey);
+        _lru.pop_back();
+    }
+}
+
+vsg::ref_ptr<vsg::Data> FetchCoalescer::cached(const vsg::Path& path, vsg::ref_ptr<const vsg::Options> options)
+{
+    auto key = _key(path, options.get());
+
+    std::scoped_lock<std::mutex> lock(_mutex);
+
+    auto itr = _lruIndex.find(key);
+    if (itr == _lruIndex.end()) return {};
+
+    _lru.splice(_lru.begin(), _lru, itr->second);
+    return itr->second->second;
+}
+
+void FetchCoalescer::trim()
+{
+    std::scoped_lock<std::mutex> lock(_mutex);
+    _trim();
+}
+
+void FetchCoalescer::clear()
+{
+    std::scoped_lock<std::mutex> lock(_mutex);
+
+    _lru.clear();
+    _lruIndex.clear();
+    _metrics.cacheSize = 0;
+}
+
+FetchCoalescer::Metrics FetchCoalescer::getMetrics() const
+{
+    std::scoped_lock<std::mutex> lock(_mutex);
+    return _metrics;
+}
@@ -0,0 +1,53 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsgGIS/ImageLayer.h>
+
+#include <vsg/io/ObjectFactory.h>
+
+using namespace vsgGIS;
+
+// Register the ImageLayer class with vsg::ObjectFactory::instance() so it can be read as part of TileDatabaseSettings.
+vsg::RegisterWithObjectFactoryProxy<vsgGIS::ImageLayer> s_Register_ImageLayer;
+
+void ImageLayer::read(vsg::Input& input)
+{
+    input.read("path", path);
+    input.read("opacity", opacity);
+
+    uint32_t mode = blendMode;
+    input.read("blendMode", mode);
+    blendMode = static_cast<BlendMode>(mode);
+
+    input.read("minLevel", minLevel);
+    input.read("maxLevel", maxLevel);
+}
+
+void ImageLayer::write(vsg::Output& output) const
+{
+    output.write("path", path);
+    output.write("opacity", opacity);
+    output.write("blendMode", static_cast<uint32_t>(blendMode));
+    output.write("minLevel", minLevel);
+    output.write("maxLevel", maxLevel);
+}
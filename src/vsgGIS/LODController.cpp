@@ -0,0 +1,171 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsgGIS/LODController.h>
+
+#include <vsg/io/Logger.h>
+
+#include <algorithm>
+#include <limits>
+
+using namespace vsgGIS;
+
+namespace
+{
+    // number of PagedLOD tracked between removing the entries of deleted PagedLOD
+    constexpr uint32_t s_prunePeriod = 256;
+
+    // screen height ratio that is never reached, so the PagedLOD always uses it's low resolution child
+    constexpr double s_neverRefine = std::numeric_limits<double>::max();
+} // namespace
+
+LODController::LODController(double in_screenHeightRatio, uint32_t in_maxLevel) :
+    _finestRatio(in_screenHeightRatio),
+    _deepestLevel(in_maxLevel),
+    _ratio(in_screenHeightRatio),
+    _maxLevel(in_maxLevel)
+{
+}
+
+LODController::~LODController()
+{
+}
+
+void LODController::_apply(uint64_t key, vsg::PagedLOD& plod) const
+{
+    // a PagedLOD at level loads the subtiles at level + 1
+    uint32_t level = static_cast<uint32_t>(key >> 58);
+    plod.children[0].minimumScreenHeightRatio = (level < _maxLevel) ? _ratio : s_neverRefine;
+}
+
+void LODController::_applyAll()
+{
+    for (auto itr = _tracked.begin(); itr != _tracked.end();)
+    {
+        if (auto plod = vsg::ref_ptr<vsg::PagedLOD>(itr->second))
+        {
+            _apply(itr->first, *plod);
+            ++itr;
+        }
+        else
+        {
+            itr = _tracked.erase(itr);
+        }
+    }
+    _numTrackedSincePrune = 0;
+}
+
+void LODController::track(uint64_t key, vsg::PagedLOD* plod)
+{
+    if (!plod) return;
+
+    std::scoped_lock<std::mutex> lock(_mutex);
+
+    _tracked[key] = vsg::observer_ptr<vsg::PagedLOD>(plod);
+    _apply(key, *plod);
+
+    if (++_numTrackedSincePrune >= s_prunePeriod)
+    {
+        for (auto itr = _tracked.begin(); itr != _tracked.end();)
+        {
+            if (itr->second.valid())
+                ++itr;
+            else
+                itr = _tracked.erase(itr);
+        }
+        _numTrackedSincePrune = 0;
+    }
+}
+
+void LODController::update(double frameTime, uint32_t numActiveRequests)
+{
+    // the fraction of each target currently in use, the largest decides the state
+    double load = targetFrameTime > 0.0 ? frameTime / targetFrameTime : 0.0;
+
+    // the pager's requests include those queued for reading, which the scheduler only sees once a read thread picks them up
+    if (targetNumActiveRequests > 0)
+    {
+        load = std::max(load, static_cast<double>(numActiveRequests) / static_cast<double>(targetNumActiveRequests));
+    }
+
+    if (memoryMonitor && memoryMonitor->maxTileMemory > 0)
+    {
+        auto report = memoryMonitor->getReport();
+        load = std::max(load, static_cast<double>(report.tiles.systemMemory()) / static_cast<double>(memoryMonitor->maxTileMemory));
+    }
+
+    int state = 0;
+    if (load > coarsenThreshold)
+        state = -1;
+    else if (load < refineThreshold)
+        state = 1;
+
+    std::scoped_lock<std::mutex> lock(_mutex);
+
+    if (state != _state)
+    {
+        _state = state;
+        _stateFrames = 0;
+    }
+
+    if (_state == 0 || ++_stateFrames < holdFrames) return;
+    _stateFrames = 0;
+
+    if (_state < 0)
+    {
+        // coarsen by raising the screen height ratio first, only reducing the maximum level once the ratio is at it's limit
+        double maxRatio = _finestRatio * maxRatioMultiplier;
+        if (_ratio < maxRatio)
+            _ratio = std::min(maxRatio, _ratio * ratioStep);
+        else if (_maxLevel > minLevel)
+            --_maxLevel;
+        else
+            return;
+    }
+    else
+    {
+        // refine in the reverse order to coarsening
+        if (_maxLevel < _deepestLevel)
+            ++_maxLevel;
+        else if (_ratio > _finestRatio)
+            _ratio = std::max(_finestRatio, _ratio / ratioStep);
+        else
+            return;
+    }
+
+    vsg::debug("LODController::update() load = ", load, ", screenHeightRatio = ", _ratio, ", maxLevel = ", _maxLevel);
+
+    _applyAll();
+}
+
+double LODController::screenHeightRatio() const
+{
+    std::scoped_lock<std::mutex> lock(_mutex);
+    return _ratio;
+}
+
+uint32_t LODController::maxLevel() const
+{
+    std::scoped_lock<std::mutex> lock(_mutex);
+    return _maxLevel;
+}
@@ -0,0 +1,299 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsgGIS/MosaicIndex.h>
+#include <vsgGIS/Reprojection.h>
+
+#include <vsg/io/Input.h>
+#include <vsg/io/Logger.h>
+#include <vsg/io/ObjectFactory.h>
+#include <vsg/io/Output.h>
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <thread>
+
+using namespace vsgGIS;
+
+// Register the MosaicIndex class with vsg::ObjectFactory::instance() so it can be used for creating objects during reading.
+vsg::RegisterWithObjectFactoryProxy<vsgGIS::MosaicIndex> s_Register_MosaicIndex;
+
+namespace
+{
+    // fill the empty pixels of image, those with all components equal to it's "NoDataValue" or 0 without one, from the pixels of source that aren't empty. Pass a null source to count the empty pixels.
+    // Return the number of pixels of image that remain empty.
+    size_t fillEmptyPixels(vsg::Data& image, const vsg::Data* source)
+    {
+        if (source && (source->getLayout().format != image.getLayout().format || source->valueCount() != image.valueCount())) source = nullptr;
+
+        return dispatchImageFormat(image.getLayout().format, [&](auto rasterType) -> size_t {
+            using RT = decltype(rasterType);
+            using T = typename RT::component_type;
+            constexpr int N = RT::numComponents;
+
+            auto emptyTest = [](const vsg::Data& data) {
+                double noDataValue = 0.0;
+                data.getValue("NoDataValue", noDataValue);
+                bool noDataIsNaN = std::isnan(noDataValue);
+                T empty = (!noDataIsNaN && isRepresentable<T>(noDataValue)) ? static_cast<T>(noDataValue) : T(0);
+                return [empty, noDataIsNaN](const T* pixel) {
+                    return std::all_of(pixel, pixel + N, [&](T v) {
+                        if constexpr (std::is_floating_point_v<T>)
+                        {
+                            if (noDataIsNaN) return std::isnan(v);
+                        }
+                        return v == empty;
+                    });
+                };
+            };
+
+            auto isEmpty = emptyTest(image);
+            T* dest = static_cast<T*>(image.dataPointer());
+            size_t numPixels = image.valueCount();
+            size_t numEmpty = 0;
+
+            if (source)
+            {
+                auto isSourceEmpty = emptyTest(*source);
+                const T* src = static_cast<const T*>(source->dataPointer());
+                for (size_t i = 0; i < numPixels; ++i, dest += N, src += N)
+                {
+                    if (!isEmpty(dest)) continue;
+
+                    if (isSourceEmpty(src))
+                        ++numEmpty;
+                    else
+                        std::copy(src, src + N, dest);
+                }
+            }
+            else
+            {
+                for (size_t i = 0; i < numPixels; ++i, dest += N)
+                {
+                    if (isEmpty(dest)) ++numEmpty;
+                }
+            }
+            return numEmpty;
+        });
+    }
+} // namespace
+
+void MosaicIndex::read(vsg::Input& input)
+{
+    Object::read(input);
+
+    entries.resize(input.readValue<uint32_t>("numEntries"));
+    for (auto& entry : entries)
+    {
+        input.read("filename", entry.filename);
+        input.read("extents", entry.extents);
+        input.read("resolution", entry.resolution);
+        input.read("priority", entry.priority);
+    }
+
+    // the packed spatial index is quick to rebuild so isn't stored
+    update();
+}
+
+void MosaicIndex::write(vsg::Output& output) const
+{
+    Object::write(output);
+
+    output.writeValue<uint32_t>("numEntries", entries.size());
+    for (auto& entry : entries)
+    {
+        output.write("filename", entry.filename);
+        output.write("extents", entry.extents);
+        output.write("resolution", entry.resolution);
+        output.write("priority", entry.priority);
+    }
+}
+
+bool MosaicIndex::computeEntry(GDALDataset& dataset, const TileDatabaseSettings& settings, Entry& entry)
+{
+    double geoTransform[6];
+    if (dataset.GetGeoTransform(geoTransform) != CE_None) return false;
+
+    int width = dataset.GetRasterXSize();
+    int height = dataset.GetRasterYSize();
+    if (width <= 0 || height <= 0) return false;
+
+    // transform from the dataset's coordinate system to longitude, latitude.
+    std::unique_ptr<OGRCoordinateTransformation, void (*)(OGRCoordinateTransformation*)> transform(nullptr, OGRCoordinateTransformation::DestroyCT);
+
+    const char* projectionRef = dataset.GetProjectionRef();
+    if (projectionRef && *projectionRef != 0)
+    {
+        OGRSpatialReference source, destination;
+        if (source.SetFromUserInput(projectionRef) != OGRERR_NONE) return false;
+        destination.SetWellKnownGeogCS("WGS84");
+#if GDAL_VERSION_MAJOR >= 3
+        source.SetAxisMappingStrategy(OAMS_TRADITIONAL_GIS_ORDER);
+        destination.SetAxisMappingStrategy(OAMS_TRADITIONAL_GIS_ORDER);
+#endif
+        if (!source.IsSame(&destination))
+        {
+            transform.reset(OGRCreateCoordinateTransformation(&source, &destination));
+            if (!transform) return false;
+        }
+    }
+
+    // sample along the edges of the dataset as the footprint edges needn't be straight once reprojected
+    const int numSamples = 8;
+    vsg::dbox extents;
+    for (int i = 0; i <= numSamples; ++i)
+    {
+        double s = double(i) / double(numSamples);
+        double pixels[4][2] = {{s * width, 0.0}, {s * width, double(height)}, {0.0, s * height}, {double(width), s * height}};
+        for (auto& pixel : pixels)
+        {
+            double x = geoTransform[0] + pixel[0] * geoTransform[1] + pixel[1] * geoTransform[2];
+            double y = geoTransform[3] + pixel[0] * geoTransform[4] + pixel[1] * geoTransform[5];
+            if (transform && !transform->Transform(1, &x, &y)) continue;
+
+            extents.add(settings.computeTileLocation(vsg::dvec3(y, x, 0.0)));
+        }
+    }
+
+    if (!extents.valid()) return false;
+
+    entry.extents = extents;
+    entry.resolution = std::max((extents.max.x - extents.min.x) / double(width), (extents.max.y - extents.min.y) / double(height));
+    return true;
+}
+
+size_t MosaicIndex::build(const vsg::Path& directory, const TileDatabaseSettings& settings, uint32_t numThreads)
+{
+    initGDAL();
+
+    std::vector<vsg::Path> filenames;
+    std::error_code error;
+    for (auto itr = std::filesystem::recursive_directory_iterator(directory.string(), error); !error && itr != std::filesystem::recursive_directory_iterator(); itr.increment(error))
+    {
+        if (itr->is_regular_file(error)) filenames.emplace_back(itr->path().string());
+    }
+
+    if (numThreads == 0) numThreads = std::max(1u, std::thread::hardware_concurrency());
+    numThreads = std::min(numThreads, static_cast<uint32_t>(filenames.size()));
+
+    // open the files in parallel as the cost is dominated by reading and parsing headers
+    std::vector<Entry> results(filenames.size());
+    std::vector<uint8_t> valid(filenames.size(), 0);
+    std::atomic<size_t> next{0};
+
+    auto process = [&]() {
+        for (size_t i = next++; i < filenames.size(); i = next++)
+        {
+            auto dataset = openDataSet(filenames[i], GA_ReadOnly);
+            if (!dataset || dataset->GetRasterCount() == 0) continue;
+
+            results[i].filename = filenames[i];
+            if (computeEntry(*dataset, settings, results[i])) valid[i] = 1;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (uint32_t i = 1; i < numThreads; ++i) threads.emplace_back(process);
+    process();
+    for (auto& thread : threads) thread.join();
+
+    size_t numAdded = 0;
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        if (valid[i])
+        {
+            entries.push_back(results[i]);
+            ++numAdded;
+        }
+    }
+
+    vsg::debug("MosaicIndex::build(", directory, ") added ", numAdded, " datasets from ", filenames.size(), " files.");
+
+    update();
+
+    return numAdded;
+}
+
+void MosaicIndex::add(const Entry& entry)
+{
+    entries.push_back(entry);
+    update();
+}
+
+void MosaicIndex::update()
+{
+    std::vector<vsg::dbox> boxes;
+    boxes.reserve(entries.size());
+    for (auto& entry : entries) boxes.push_back(entry.extents);
+
+    _index.build(boxes);
+}
+
+std::vector<const MosaicIndex::Entry*> MosaicIndex::query(const vsg::dbox& extents, double minResolution, double maxResolution) const
+{
+    std::vector<const Entry*> matches;
+    _index.intersect(extents, [&](uint32_t index) {
+        auto& entry = entries[index];
+        if (entry.resolution >= minResolution && entry.resolution <= maxResolution) matches.push_back(&entry);
+    });
+
+    std::sort(matches.begin(), matches.end(), [](const Entry* lhs, const Entry* rhs) {
+        if (lhs->priority != rhs->priority) return lhs->priority > rhs->priority;
+        return lhs->resolution < rhs->resolution;
+    });
+
+    return matches;
+}
+
+vsg::ref_ptr<vsg::Data> MosaicIndex::createImage(const TileDatabaseSettings& settings, uint32_t x, uint32_t y, uint32_t level, uint32_t width, uint32_t height, DatasetPool& datasetPool) const
+{
+    auto extents = settings.computeTileExtents(x, y, level);
+    std::string projection = settings.projection.empty() ? std::string("EPSG:4326") : settings.projection;
+
+    vsg::ref_ptr<vsg::Data> image;
+    for (auto entry : query(extents))
+    {
+        auto dataset = datasetPool.acquire(entry->filename, GA_ReadOnly);
+        if (!dataset) continue;
+
+        auto source = reprojectToImage(*dataset, projection, extents, width, height);
+        if (!source) continue;
+
+        size_t numEmpty = 0;
+        if (image)
+        {
+            numEmpty = fillEmptyPixels(*image, source);
+        }
+        else
+        {
+            image = source;
+            numEmpty = fillEmptyPixels(*image, nullptr);
+        }
+
+        // datasets further down the query order can't change a tile that is already covered
+        if (numEmpty == 0) break;
+    }
+
+    return image;
+}
@@ -0,0 +1,205 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsgGIS/PhotoCatalog.h>
+#include <vsgGIS/meta_utils.h>
+
+#include <vsg/io/Input.h>
+#include <vsg/io/Logger.h>
+#include <vsg/io/ObjectFactory.h>
+#include <vsg/io/Output.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+using namespace vsgGIS;
+
+// Register the PhotoCatalog class with vsg::ObjectFactory::instance() so it can be used for creating objects during reading.
+vsg::RegisterWithObjectFactoryProxy<vsgGIS::PhotoCatalog> s_Register_PhotoCatalog;
+
+namespace
+{
+    // mean radius of the earth in meters, accurate enough for selecting photos by distance
+    constexpr double s_earthRadius = 6371008.8;
+
+    double greatCircleDistance(double latitude1, double longitude1, double latitude2, double longitude2)
+    {
+        double sinHalfLatitude = std::sin(vsg::radians(latitude2 - latitude1) * 0.5);
+        double sinHalfLongitude = std::sin(vsg::radians(longitude2 - longitude1) * 0.5);
+        double a = sinHalfLatitude * sinHalfLatitude + std::cos(vsg::radians(latitude1)) * std::cos(vsg::radians(latitude2)) * sinHalfLongitude * sinHalfLongitude;
+        return 2.0 * s_earthRadius * std::asin(std::min(1.0, std::sqrt(a)));
+    }
+} // namespace
+
+void PhotoCatalog::read(vsg::Input& input)
+{
+    Object::read(input);
+
+    photos.resize(input.readValue<uint32_t>("numPhotos"));
+    for (auto& photo : photos)
+    {
+        input.read("filename", photo.filename);
+        input.read("location", photo.location);
+    }
+
+    // the packed spatial index is quick to rebuild so isn't stored
+    update();
+}
+
+void PhotoCatalog::write(vsg::Output& output) const
+{
+    Object::write(output);
+
+    output.writeValue<uint32_t>("numPhotos", photos.size());
+    for (auto& photo : photos)
+    {
+        output.write("filename", photo.filename);
+        output.write("location", photo.location);
+    }
+}
+
+size_t PhotoCatalog::ingest(const vsg::Paths& filenames, uint32_t numThreads)
+{
+    initGDAL();
+
+    if (numThreads == 0) numThreads = std::max(1u, std::thread::hardware_concurrency());
+    numThreads = std::min(numThreads, static_cast<uint32_t>(filenames.size()));
+
+    std::vector<Photo> results(filenames.size());
+    std::vector<uint8_t> valid(filenames.size(), 0);
+    std::atomic<size_t> next{0};
+
+    auto process = [&]() {
+        // by default GDAL lists the directory of each file it opens looking for sidecar files, which dominates open times in directories of thousands of photos
+        CPLSetThreadLocalConfigOption("GDAL_DISABLE_READDIR_ON_OPEN", "EMPTY_DIR");
+
+        // only probe the drivers that can hold EXIF tags rather than every registered driver
+        const char* const allowedDrivers[] = {"JPEG", "GTiff", nullptr};
+
+        for (size_t i = next++; i < filenames.size(); i = next++)
+        {
+            // opening a dataset only reads it's header and meta data, no raster data is read
+            auto dataset = static_cast<GDALDataset*>(GDALOpenEx(filenames[i].string().c_str(), GDAL_OF_RASTER | GDAL_OF_READONLY, allowedDrivers, nullptr, nullptr));
+            if (!dataset) continue;
+
+            double latitude = std::numeric_limits<double>::quiet_NaN();
+            double longitude = std::numeric_limits<double>::quiet_NaN();
+            double altitude = 0.0;
+            if (getEXIF_LatitudeLongitudeAlititude(dataset->GetMetadata(), latitude, longitude, altitude) && std::isfinite(latitude) && std::isfinite(longitude))
+            {
+                results[i].filename = filenames[i];
+                results[i].location.set(latitude, longitude, altitude);
+                valid[i] = 1;
+            }
+
+            GDALClose(dataset);
+        }
+
+        CPLSetThreadLocalConfigOption("GDAL_DISABLE_READDIR_ON_OPEN", nullptr);
+    };
+
+    std::vector<std::thread> threads;
+    for (uint32_t i = 1; i < numThreads; ++i) threads.emplace_back(process);
+    process();
+    for (auto& thread : threads) thread.join();
+
+    size_t numAdded = 0;
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        if (valid[i])
+        {
+            photos.push_back(results[i]);
+            ++numAdded;
+        }
+    }
+
+    vsg::debug("PhotoCatalog::ingest() added ", numAdded, " geotagged photos from ", filenames.size(), " files.");
+
+    update();
+
+    return numAdded;
+}
+
+void PhotoCatalog::update()
+{
+    std::vector<vsg::dbox> boxes;
+    boxes.reserve(photos.size());
+    for (auto& photo : photos)
+    {
+        vsg::dvec3 point(photo.location.y, photo.location.x, 0.0);
+        boxes.emplace_back(point, point);
+    }
+
+    _index.build(boxes);
+}
+
+std::vector<const PhotoCatalog::Photo*> PhotoCatalog::query(const vsg::dbox& extents) const
+{
+    std::vector<const Photo*> matches;
+    _index.intersect(extents, [&](uint32_t index) { matches.push_back(&photos[index]); });
+    return matches;
+}
+
+std::vector<const PhotoCatalog::Photo*> PhotoCatalog::query(double latitude, double longitude, double radius) const
+{
+    // select candidates within a box enclosing the circle, then test their actual distance
+    double deltaLatitude = vsg::degrees(radius / s_earthRadius);
+    double deltaLongitude = std::min(180.0, deltaLatitude / std::max(1e-6, std::cos(vsg::radians(latitude))));
+    vsg::dbox extents(vsg::dvec3(longitude - deltaLongitude, latitude - deltaLatitude, 0.0), vsg::dvec3(longitude + deltaLongitude, latitude + deltaLatitude, 0.0));
+
+    std::vector<std::pair<double, const Photo*>> candidates;
+    _index.intersect(extents, [&](uint32_t index) {
+        auto& photo = photos[index];
+        double distance = greatCircleDistance(latitude, longitude, photo.location.x, photo.location.y);
+        if (distance <= radius) candidates.emplace_back(distance, &photo);
+    });
+
+    std::sort(candidates.begin(), candidates.end(), [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+
+    std::vector<const Photo*> matches;
+    matches.reserve(candidates.size());
+    for (auto& candidate : candidates) matches.push_back(candidate.second);
+    return matches;
+}
+
+std::vector<const PhotoCatalog::Photo*> PhotoCatalog::query(const TileDatabaseSettings& settings, uint32_t x, uint32_t y, uint32_t level) const
+{
+    auto tile_extents = settings.computeTileExtents(x, y, level);
+
+    // the tile edges needn't be lines of latitude and longitude so bound the corners and edge midpoints
+    vsg::dbox extents;
+    for (int r = 0; r <= 2; ++r)
+    {
+        for (int c = 0; c <= 2; ++c)
+        {
+            vsg::dvec3 location(tile_extents.min.x + (tile_extents.max.x - tile_extents.min.x) * 0.5 * c, tile_extents.min.y + (tile_extents.max.y - tile_extents.min.y) * 0.5 * r, 0.0);
+            auto latitudeLongitudeAltitude = settings.computeLatitudeLongitudeAltitude(location);
+            extents.add(vsg::dvec3(latitudeLongitudeAltitude.y, latitudeLongitudeAltitude.x, 0.0));
+        }
+    }
+
+    return query(extents);
+}
@@ -0,0 +1,384 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsgGIS/Reprojection.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <mutex>
+
+using namespace vsgGIS;
+
+namespace
+{
+    struct DestroyTransformation
+    {
+        void operator()(OGRCoordinateTransformation* transformation) const { OGRCoordinateTransformation::DestroyCT(transformation); }
+    };
+
+    bool createSpatialReference(const std::string& definition, OGRSpatialReference& srs)
+    {
+        if (srs.SetFromUserInput(definition.c_str()) != OGRERR_NONE) return false;
+#if GDAL_VERSION_MAJOR >= 3
+        // keep x as easting/longitude and y as northing/latitude regardless of the axis order the authority defines
+        srs.SetAxisMappingStrategy(OAMS_TRADITIONAL_GIS_ORDER);
+#endif
+        return true;
+    }
+
+    // return the calling thread's OGRCoordinateTransformation for the source, destination pair, creating it on first use.
+    OGRCoordinateTransformation* threadTransformation(const std::string& source, const std::string& destination)
+    {
+        thread_local std::map<std::pair<std::string, std::string>, std::unique_ptr<OGRCoordinateTransformation, DestroyTransformation>> s_transformations;
+
+        auto& transformation = s_transformations[std::make_pair(source, destination)];
+        if (!transformation)
+        {
+            OGRSpatialReference sourceSRS, destinationSRS;
+            if (createSpatialReference(source, sourceSRS) && createSpatialReference(destination, destinationSRS))
+            {
+                transformation.reset(OGRCreateCoordinateTransformation(&sourceSRS, &destinationSRS));
+            }
+        }
+        return transformation.get();
+    }
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Reprojection
+//
+Reprojection::Reprojection(const std::string& in_source, const std::string& in_destination) :
+    source(in_source),
+    destination(in_destination)
+{
+    initGDAL();
+
+    OGRSpatialReference sourceSRS, destinationSRS;
+    _valid = createSpatialReference(source, sourceSRS) && createSpatialReference(destination, destinationSRS);
+    _identity = _valid && (source == destination || sourceSRS.IsSame(&destinationSRS));
+}
+
+vsg::ref_ptr<Reprojection> Reprojection::get(const std::string& source, const std::string& destination)
+{
+    static std::mutex s_mutex;
+    static std::map<std::pair<std::string, std::string>, vsg::ref_ptr<Reprojection>> s_reprojections;
+
+    std::scoped_lock<std::mutex> lock(s_mutex);
+
+    auto& reprojection = s_reprojections[std::make_pair(source, destination)];
+    if (!reprojection) reprojection = Reprojection::create(source, destination);
+    return reprojection;
+}
+
+bool Reprojection::transform(size_t count, vsg::dvec3* coords) const
+{
+    if (!_valid) return false;
+    if (_identity) return true;
+
+    auto transformation = threadTransformation(source, destination);
+    if (!transformation) return false;
+
+    // OGR takes separate x, y and z arrays so transform in chunks of a fixed size
+    constexpr size_t chunkSize = 256;
+    double x[chunkSize], y[chunkSize], z[chunkSize];
+    int success[chunkSize];
+
+    bool result = true;
+    for (size_t begin = 0; begin < count; begin += chunkSize)
+    {
+        size_t n = std::min(chunkSize, count - begin);
+        vsg::dvec3* chunk = coords + begin;
+        for (size_t i = 0; i < n; ++i)
+        {
+            x[i] = chunk[i].x;
+            y[i] = chunk[i].y;
+            z[i] = chunk[i].z;
+            success[i] = FALSE;
+        }
+
+        transformation->Transform(static_cast<int>(n), x, y, z, success);
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            if (success[i])
+                chunk[i] = vsg::dvec3(x[i], y[i], z[i]);
+            else
+                result = false;
+        }
+    }
+    return result;
+}
+
+vsg::ref_ptr<ReprojectionGrid> Reprojection::createGrid(const vsg::dbox& extents, double errorThreshold, uint32_t maxResolution) const
+{
+    if (!_valid || !extents.valid()) return {};
+
+    auto gridLocation = [&](uint32_t resolution, uint32_t c, uint32_t r) {
+        return vsg::dvec3(extents.min.x + (extents.max.x - extents.min.x) * double(c) / double(resolution), extents.min.y + (extents.max.y - extents.min.y) * double(r) / double(resolution), 0.0);
+    };
+
+    auto grid = ReprojectionGrid::create();
+    grid->extents = extents;
+    grid->resolution = 1;
+    grid->points = {gridLocation(1, 0, 0), gridLocation(1, 1, 0), gridLocation(1, 0, 1), gridLocation(1, 1, 1)};
+    if (!transform(grid->points.size(), grid->points.data())) return {};
+
+    // an identity transform is exactly represented by it's corners
+    if (_identity) return grid;
+
+    // double the resolution until interpolating the coarser grid matches the finer grid to within errorThreshold.
+    // Interpolating the finer grid is at least as accurate so it's kept, with the error of the coarser grid as a conservative estimate.
+    // The even rows and columns of the finer grid are the control points of the coarser grid, so only the new points are transformed at each level
+    // and each point of the final grid is transformed exactly once.
+    std::vector<vsg::dvec3> finerPoints;
+    std::vector<vsg::dvec3> newPoints;
+    while (grid->resolution < maxResolution)
+    {
+        uint32_t resolution = grid->resolution;
+        uint32_t finerResolution = resolution * 2;
+        uint32_t finerSize = finerResolution + 1;
+
+        newPoints.clear();
+        for (uint32_t r = 0; r < finerSize; ++r)
+        {
+            for (uint32_t c = 0; c < finerSize; ++c)
+            {
+                if (((r | c) & 1) != 0) newPoints.push_back(gridLocation(finerResolution, c, r));
+            }
+        }
+
+        // keep the source locations of the new points to measure the error of interpolating the coarser grid at them
+        std::vector<vsg::dvec3> transformedPoints(newPoints);
+        if (!transform(transformedPoints.size(), transformedPoints.data())) return {};
+
+        finerPoints.resize(size_t(finerSize) * finerSize);
+
+        double error = 0.0;
+        size_t ni = 0;
+        for (uint32_t r = 0; r < finerSize; ++r)
+        {
+            for (uint32_t c = 0; c < finerSize; ++c)
+            {
+                auto& point = finerPoints[c + r * finerSize];
+                if (((r | c) & 1) == 0)
+                {
+                    // control points of the coarser grid have no error
+                    point = grid->points[(c / 2) + (r / 2) * (resolution + 1)];
+                }
+                else
+                {
+                    point = transformedPoints[ni];
+                    error = std::max(error, vsg::length(grid->transform(newPoints[ni]) - point));
+                    ++ni;
+                }
+            }
+        }
+
+        grid->points.swap(finerPoints);
+        grid->resolution = finerResolution;
+        grid->maxError = error;
+
+        if (error <= errorThreshold) break;
+    }
+
+    return grid;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  ReprojectionGrid
+//
+vsg::dvec3 ReprojectionGrid::transform(const vsg::dvec3& src) const
+{
+    double width = extents.max.x - extents.min.x;
+    double height = extents.max.y - extents.min.y;
+    double fx = width > 0.0 ? (src.x - extents.min.x) * double(resolution) / width : 0.0;
+    double fy = height > 0.0 ? (src.y - extents.min.y) * double(resolution) / height : 0.0;
+
+    int maxCell = static_cast<int>(resolution) - 1;
+    int c = std::clamp(static_cast<int>(std::floor(fx)), 0, maxCell);
+    int r = std::clamp(static_cast<int>(std::floor(fy)), 0, maxCell);
+    double tx = fx - double(c);
+    double ty = fy - double(r);
+
+    size_t rowSize = resolution + 1;
+    const vsg::dvec3& p00 = points[c + r * rowSize];
+    const vsg::dvec3& p10 = points[c + 1 + r * rowSize];
+    const vsg::dvec3& p01 = points[c + (r + 1) * rowSize];
+    const vsg::dvec3& p11 = points[c + 1 + (r + 1) * rowSize];
+
+    vsg::dvec3 result = (p00 * (1.0 - tx) + p10 * tx) * (1.0 - ty) + (p01 * (1.0 - tx) + p11 * tx) * ty;
+    result.z += src.z;
+    return result;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  reprojectToImage
+//
+vsg::ref_ptr<vsg::Data> vsgGIS::reprojectToImage(GDALDataset& dataset, const std::string& projection, const vsg::dbox& extents, uint32_t width, uint32_t height, double errorThreshold, ResampleMethod method)
+{
+    int numBands = dataset.GetRasterCount();
+    if (numBands < 1 || numBands > 4 || width == 0 || height == 0) return {};
+
+    double geoTransform[6];
+    double inverseGeoTransform[6];
+    if (dataset.GetGeoTransform(geoTransform) != CE_None || !GDALInvGeoTransform(geoTransform, inverseGeoTransform)) return {};
+
+    // a dataset without a projection is assumed to already be in the destination projection
+    const char* projectionRef = dataset.GetProjectionRef();
+    auto reprojection = Reprojection::get(projection, (projectionRef && *projectionRef) ? std::string(projectionRef) : projection);
+    if (!reprojection->valid()) return {};
+
+    // errorThreshold is in source pixels, the grid works in source coordinates
+    double pixelSize = std::min(std::hypot(geoTransform[1], geoTransform[4]), std::hypot(geoTransform[2], geoTransform[5]));
+    auto grid = reprojection->createGrid(extents, errorThreshold * pixelSize);
+    if (!grid) return {};
+
+    // compute the source pixel coordinates of the centre of each destination pixel, with rows ordered top down to match GDAL
+    std::vector<vsg::dvec2> sourcePixels(size_t(width) * height);
+    vsg::dvec2 minPixel(std::numeric_limits<double>::max(), std::numeric_limits<double>::max());
+    vsg::dvec2 maxPixel(std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest());
+
+    double dx = (extents.max.x - extents.min.x) / double(width);
+    double dy = (extents.max.y - extents.min.y) / double(height);
+    auto pixelItr = sourcePixels.begin();
+    for (uint32_t j = 0; j < height; ++j)
+    {
+        for (uint32_t i = 0; i < width; ++i)
+        {
+            auto s = grid->transform(vsg::dvec3(extents.min.x + (double(i) + 0.5) * dx, extents.max.y - (double(j) + 0.5) * dy, 0.0));
+            vsg::dvec2 pixel(inverseGeoTransform[0] + s.x * inverseGeoTransform[1] + s.y * inverseGeoTransform[2],
+                             inverseGeoTransform[3] + s.x * inverseGeoTransform[4] + s.y * inverseGeoTransform[5]);
+
+            minPixel.set(std::min(minPixel.x, pixel.x), std::min(minPixel.y, pixel.y));
+            maxPixel.set(std::max(maxPixel.x, pixel.x), std::max(maxPixel.y, pixel.y));
+            *(pixelItr++) = pixel;
+        }
+    }
+
+    // only read the window of the dataset that the destination pixels sample, with a one pixel border for bilinear filtering
+    int xOff = std::max(0, static_cast<int>(std::floor(minPixel.x)) - 1);
+    int yOff = std::max(0, static_cast<int>(std::floor(minPixel.y)) - 1);
+    int xEnd = std::min(dataset.GetRasterXSize(), static_cast<int>(std::ceil(maxPixel.x)) + 1);
+    int yEnd = std::min(dataset.GetRasterYSize(), static_cast<int>(std::ceil(maxPixel.y)) + 1);
+    if (xEnd <= xOff || yEnd <= yOff) return {};
+
+    int xSize = xEnd - xOff;
+    int ySize = yEnd - yOff;
+
+    // when the destination pixels are larger than the source pixels read a reduced resolution window so GDAL can use overviews
+    double reduction = std::max(1.0, std::min(double(xSize) / double(width), double(ySize) / double(height)));
+    int bufferWidth = std::max(1, static_cast<int>(std::ceil(double(xSize) / reduction)));
+    int bufferHeight = std::max(1, static_cast<int>(std::ceil(double(ySize) / reduction)));
+    double scaleX = double(bufferWidth) / double(xSize);
+    double scaleY = double(bufferHeight) / double(ySize);
+
+    GDALDataType dataType = dataset.GetRasterBand(1)->GetRasterDataType();
+    auto image = createImage2D(width, height, numBands, dataType);
+    if (!image) return {};
+
+    GDALRasterIOExtraArg extraArg;
+    INIT_RASTERIO_EXTRA_ARG(extraArg);
+    switch (method)
+    {
+    case (RESAMPLE_NEAREST): extraArg.eResampleAlg = GRIORA_NearestNeighbour; break;
+    case (RESAMPLE_AVERAGE): extraArg.eResampleAlg = GRIORA_Average; break;
+    case (RESAMPLE_BILINEAR): extraArg.eResampleAlg = GRIORA_Bilinear; break;
+    }
+
+    bool result = dispatchDataType(dataType, [&](auto value) -> bool {
+        using T = decltype(value);
+
+        T* dest = reinterpret_cast<T*>(image->dataPointer());
+        std::vector<T> buffer(size_t(bufferWidth) * bufferHeight);
+
+        for (int b = 0; b < numBands; ++b)
+        {
+            GDALRasterBand* band = dataset.GetRasterBand(b + 1);
+            if (band->GetRasterDataType() != dataType) return false;
+
+            if (band->RasterIO(GF_Read, xOff, yOff, xSize, ySize, buffer.data(), bufferWidth, bufferHeight, dataType, 0, 0, &extraArg) != CE_None) return false;
+
+            // a NoData value the data type can't hold never occurs in the band, so is ignored
+            int hasNoData = FALSE;
+            double noDataValue = band->GetNoDataValue(&hasNoData);
+            bool validNoData = hasNoData && isRepresentable<T>(noDataValue);
+            bool noDataIsNaN = validNoData && std::isnan(noDataValue);
+            T fill = validNoData ? static_cast<T>(noDataValue) : T(0);
+            if (validNoData && b == 0) image->setValue("NoDataValue", noDataValue);
+
+            auto isNoData = [&](T v) {
+                if (!validNoData) return false;
+                return noDataIsNaN ? std::isnan(static_cast<double>(v)) : static_cast<double>(v) == noDataValue;
+            };
+
+            for (size_t i = 0; i < sourcePixels.size(); ++i)
+            {
+                double bx = (sourcePixels[i].x - double(xOff)) * scaleX;
+                double by = (sourcePixels[i].y - double(yOff)) * scaleY;
+
+                T v = fill;
+                if (bx >= 0.0 && by >= 0.0 && bx < double(bufferWidth) && by < double(bufferHeight))
+                {
+                    T nearest = buffer[static_cast<size_t>(bx) + static_cast<size_t>(by) * bufferWidth];
+                    v = nearest;
+                    if (method != RESAMPLE_NEAREST)
+                    {
+                        // interpolate between the centres of the four nearest pixels
+                        double fx = std::floor(bx - 0.5);
+                        double fy = std::floor(by - 0.5);
+                        double tx = bx - 0.5 - fx;
+                        double ty = by - 0.5 - fy;
+                        int x0 = std::clamp(static_cast<int>(fx), 0, bufferWidth - 1);
+                        int x1 = std::clamp(static_cast<int>(fx) + 1, 0, bufferWidth - 1);
+                        int y0 = std::clamp(static_cast<int>(fy), 0, bufferHeight - 1);
+                        int y1 = std::clamp(static_cast<int>(fy) + 1, 0, bufferHeight - 1);
+
+                        T v00 = buffer[x0 + size_t(y0) * bufferWidth];
+                        T v10 = buffer[x1 + size_t(y0) * bufferWidth];
+                        T v01 = buffer[x0 + size_t(y1) * bufferWidth];
+                        T v11 = buffer[x1 + size_t(y1) * bufferWidth];
+
+                        // NoData values mustn't be blended with valid values so fall back to the nearest pixel
+                        if (!isNoData(v00) && !isNoData(v10) && !isNoData(v01) && !isNoData(v11))
+                        {
+                            double interpolated = (double(v00) * (1.0 - tx) + double(v10) * tx) * (1.0 - ty) + (double(v01) * (1.0 - tx) + double(v11) * tx) * ty;
+                            if constexpr (std::is_integral_v<T>)
+                                v = static_cast<T>(std::floor(interpolated + 0.5));
+                            else
+                                v = static_cast<T>(interpolated);
+                        }
+                    }
+                }
+                dest[i * numBands + b] = v;
+            }
+        }
+        return true;
+    });
+
+    return result ? image : vsg::ref_ptr<vsg::Data>();
+}
@@ -0,0 +1,125 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsgGIS/SpatialIndex.h>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+using namespace vsgGIS;
+
+namespace
+{
+    inline double centerX(const vsg::dbox& box) { return (box.min.x + box.max.x) * 0.5; }
+    inline double centerY(const vsg::dbox& box) { return (box.min.y + box.max.y) * 0.5; }
+
+    // order indices into runs of maxNodeSize using Sort-Tile-Recursive, sorting into vertical slices by x then each slice by y
+    void sortTileRecursive(std::vector<uint32_t>& indices, const std::vector<vsg::dbox>& boxes, uint32_t maxNodeSize)
+    {
+        size_t numNodes = (indices.size() + maxNodeSize - 1) / maxNodeSize;
+        size_t numSlices = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(numNodes))));
+        size_t sliceSize = numSlices * maxNodeSize;
+
+        std::sort(indices.begin(), indices.end(), [&](uint32_t lhs, uint32_t rhs) { return centerX(boxes[lhs]) < centerX(boxes[rhs]); });
+
+        for (size_t begin = 0; begin < indices.size(); begin += sliceSize)
+        {
+            auto first = indices.begin() + begin;
+            auto last = indices.begin() + std::min(indices.size(), begin + sliceSize);
+            std::sort(first, last, [&](uint32_t lhs, uint32_t rhs) { return centerY(boxes[lhs]) < centerY(boxes[rhs]); });
+        }
+    }
+} // namespace
+
+void SpatialIndex::build(const std::vector<vsg::dbox>& boxes, uint32_t maxNodeSize)
+{
+    clear();
+
+    if (boxes.empty()) return;
+
+    // bound the fan out so the traversal stack in intersect(..) can't overflow
+    maxNodeSize = std::min(32u, std::max(2u, maxNodeSize));
+
+    // leaf level
+    _items.resize(boxes.size());
+    std::iota(_items.begin(), _items.end(), 0u);
+    sortTileRecursive(_items, boxes, maxNodeSize);
+
+    _itemBounds.reserve(_items.size());
+    for (auto index : _items) _itemBounds.push_back(boxes[index]);
+
+    for (uint32_t first = 0; first < _items.size(); first += maxNodeSize)
+    {
+        Node node;
+        node.first = first;
+        node.count = std::min(maxNodeSize, static_cast<uint32_t>(_items.size()) - first);
+        node.leaf = true;
+        for (uint32_t i = node.first; i < node.first + node.count; ++i) node.bounds.add(_itemBounds[i]);
+        _nodes.push_back(node);
+    }
+
+    // build the upper levels until a single root node remains
+    uint32_t levelBegin = 0;
+    uint32_t levelEnd = static_cast<uint32_t>(_nodes.size());
+    while (levelEnd - levelBegin > 1)
+    {
+        std::vector<vsg::dbox> levelBounds;
+        std::vector<uint32_t> order(levelEnd - levelBegin);
+        for (uint32_t i = levelBegin; i < levelEnd; ++i) levelBounds.push_back(_nodes[i].bounds);
+        std::iota(order.begin(), order.end(), 0u);
+        sortTileRecursive(order, levelBounds, maxNodeSize);
+
+        // reorder the nodes of this level so each parent's children are contiguous
+        std::vector<Node> levelNodes;
+        levelNodes.reserve(order.size());
+        for (auto index : order) levelNodes.push_back(_nodes[levelBegin + index]);
+        std::copy(levelNodes.begin(), levelNodes.end(), _nodes.begin() + levelBegin);
+
+        for (uint32_t first = levelBegin; first < levelEnd; first += maxNodeSize)
+        {
+            Node node;
+            node.first = first;
+            node.count = std::min(maxNodeSize, levelEnd - first);
+            for (uint32_t i = node.first; i < node.first + node.count; ++i) node.bounds.add(_nodes[i].bounds);
+            _nodes.push_back(node);
+        }
+
+        levelBegin = levelEnd;
+        levelEnd = static_cast<uint32_t>(_nodes.size());
+    }
+}
+
+void SpatialIndex::clear()
+{
+    _nodes.clear();
+    _items.clear();
+    _itemBounds.clear();
+}
+
+std::vector<uint32_t> SpatialIndex::intersect(const vsg::dbox& box) const
+{
+    std::vector<uint32_t> indices;
+    intersect(box, [&](uint32_t index) { indices.push_back(index); });
+    return indices;
+}
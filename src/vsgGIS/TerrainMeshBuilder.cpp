@@ -0,0 +1,167 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsgGIS/TerrainMeshBuilder.h>
+
+#include <algorithm>
+#include <cstdlib>
+
+using namespace vsgGIS;
+
+TerrainMeshBuilder::TerrainMeshBuilder(uint32_t in_gridSize) :
+    gridSize(in_gridSize)
+{
+    uint32_t tileSize = gridSize - 1;
+    uint32_t numTriangles = tileSize * tileSize * 2 - 2;
+    _numParentTriangles = numTriangles - tileSize * tileSize;
+
+    // the triangles are numbered as a binary tree, with the two root triangles split by the diagonal of the grid as ids 2 and 3 and the children of id as 2 * id and 2 * id + 1.
+    // Walk the path from the root to each triangle to find it's hypotenuse.
+    _coords.resize(size_t(numTriangles) * 4);
+    for (uint32_t i = 0; i < numTriangles; ++i)
+    {
+        uint32_t id = i + 2;
+        uint32_t ax = 0, ay = 0, bx = 0, by = 0, cx = 0, cy = 0;
+        if (id & 1)
+        {
+            bx = by = cx = tileSize;
+        }
+        else
+        {
+            ax = ay = cy = tileSize;
+        }
+
+        while ((id >>= 1) > 1)
+        {
+            uint32_t mx = (ax + bx) >> 1;
+            uint32_t my = (ay + by) >> 1;
+
+            if (id & 1)
+            {
+                bx = ax;
+                by = ay;
+                ax = cx;
+                ay = cy;
+            }
+            else
+            {
+                ax = bx;
+                ay = by;
+                bx = cx;
+                by = cy;
+            }
+            cx = mx;
+            cy = my;
+        }
+
+        uint16_t* coords = &_coords[size_t(i) * 4];
+        coords[0] = static_cast<uint16_t>(ax);
+        coords[1] = static_cast<uint16_t>(ay);
+        coords[2] = static_cast<uint16_t>(bx);
+        coords[3] = static_cast<uint16_t>(by);
+    }
+}
+
+std::vector<float> TerrainMeshBuilder::computeErrors(const vsg::vec3* positions) const
+{
+    std::vector<float> errors(size_t(gridSize) * gridSize, 0.0f);
+
+    // visit children before their parents so each parent's error includes those of the triangles below it
+    uint32_t numTriangles = static_cast<uint32_t>(_coords.size() / 4);
+    for (uint32_t i = numTriangles; i-- > 0;)
+    {
+        const uint16_t* coords = &_coords[size_t(i) * 4];
+        uint32_t ax = coords[0], ay = coords[1], bx = coords[2], by = coords[3];
+        uint32_t mx = (ax + bx) >> 1;
+        uint32_t my = (ay + by) >> 1;
+
+        uint32_t middleIndex = mx + my * gridSize;
+        vsg::vec3 interpolated = (positions[ax + ay * gridSize] + positions[bx + by * gridSize]) * 0.5f;
+        float& error = errors[middleIndex];
+        error = std::max(error, vsg::length(positions[middleIndex] - interpolated));
+
+        if (i < _numParentTriangles)
+        {
+            uint32_t cx = mx + my - ay;
+            uint32_t cy = my + ax - mx;
+            uint32_t leftChildIndex = ((ax + cx) >> 1) + ((ay + cy) >> 1) * gridSize;
+            uint32_t rightChildIndex = ((bx + cx) >> 1) + ((by + cy) >> 1) * gridSize;
+            error = std::max(error, std::max(errors[leftChildIndex], errors[rightChildIndex]));
+        }
+    }
+
+    return errors;
+}
+
+float TerrainMeshBuilder::createMesh(const std::vector<float>& errors, float maxError, std::vector<uint32_t>& gridIndices, std::vector<uint16_t>& indices) const
+{
+    uint32_t tileSize = gridSize - 1;
+
+    // index + 1 of each grid vertex used, 0 for unused
+    std::vector<uint16_t> vertexIndices(size_t(gridSize) * gridSize, 0);
+    float geometricError = 0.0f;
+
+    gridIndices.clear();
+    indices.clear();
+
+    auto vertex = [&](uint32_t x, uint32_t y) -> uint16_t {
+        uint32_t gridIndex = x + y * gridSize;
+        uint16_t& vertexIndex = vertexIndices[gridIndex];
+        if (vertexIndex == 0)
+        {
+            gridIndices.push_back(gridIndex);
+            vertexIndex = static_cast<uint16_t>(gridIndices.size());
+        }
+        return vertexIndex - 1;
+    };
+
+    auto processTriangle = [&](auto& self, uint32_t ax, uint32_t ay, uint32_t bx, uint32_t by, uint32_t cx, uint32_t cy) -> void {
+        uint32_t mx = (ax + bx) >> 1;
+        uint32_t my = (ay + by) >> 1;
+
+        bool canSplit = (std::abs(int(ax) - int(cx)) + std::abs(int(ay) - int(cy))) > 1;
+        float error = canSplit ? errors[mx + my * gridSize] : 0.0f;
+        if (canSplit && error > maxError)
+        {
+            self(self, cx, cy, ax, ay, mx, my);
+            self(self, bx, by, cx, cy, mx, my);
+        }
+        else
+        {
+            geometricError = std::max(geometricError, error);
+
+            // a, b, c are wound clockwise with row 0 at the bottom so emit a, c, b
+            uint16_t a = vertex(ax, ay);
+            uint16_t b = vertex(bx, by);
+            uint16_t c = vertex(cx, cy);
+            indices.push_back(a);
+            indices.push_back(c);
+            indices.push_back(b);
+        }
+    };
+
+    processTriangle(processTriangle, 0, 0, tileSize, tileSize, tileSize, 0);
+    processTriangle(processTriangle, tileSize, tileSize, 0, 0, 0, tileSize);
+
+    return geometricError;
+}
@@ -0,0 +1,530 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsgGIS/TileArchive.h>
+#include <vsgGIS/gdal_utils.h>
+#include <vsgGIS/io_utils.h>
+
+#include <vsg/core/Array2D.h>
+#include <vsg/io/Logger.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#if defined(_WIN32)
+#    include <memory>
+#else
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+using namespace vsgGIS;
+
+static const char s_archiveMagic[8] = {'v', 's', 'g', 't', 'i', 'l', 'e', 's'};
+static constexpr uint64_t s_payloadAlignment = 16;
+
+namespace
+{
+    template<class A>
+    vsg::ref_ptr<vsg::Data> createArray2D(const TileArchive::Entry& entry, uint8_t* ptr, const vsg::Data::Layout& layout)
+    {
+        return A::create(entry.width, entry.height, reinterpret_cast<typename A::value_type*>(ptr), layout);
+    }
+
+    // the meta data values held by the Entry, in ValueMask bit order
+    struct MetaDataValue
+    {
+        const char* name;
+        double TileArchive::Entry::*value;
+    };
+
+    const MetaDataValue s_metaDataValues[] = {
+        {"offset", &TileArchive::Entry::offsetValue},
+        {"scale", &TileArchive::Entry::scaleValue},
+        {"NoDataValue", &TileArchive::Entry::noDataValue},
+        {"NoDataSample", &TileArchive::Entry::noDataSample}};
+
+    uint64_t alignedOffset(uint64_t offset)
+    {
+        return ((offset + s_payloadAlignment - 1) / s_payloadAlignment) * s_payloadAlignment;
+    }
+
+    void setMetaData(const TileArchive::Entry& entry, vsg::Data& data)
+    {
+        for (uint32_t i = 0; i < std::size(s_metaDataValues); ++i)
+        {
+            if (entry.valueMask & (1u << i)) data.setValue(s_metaDataValues[i].name, entry.*s_metaDataValues[i].value);
+        }
+    }
+
+    void getMetaData(const vsg::Data& data, TileArchive::Entry& entry)
+    {
+        for (uint32_t i = 0; i < std::size(s_metaDataValues); ++i)
+        {
+            if (data.getValue(s_metaDataValues[i].name, entry.*s_metaDataValues[i].value)) entry.valueMask |= (1u << i);
+        }
+    }
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  TileArchive
+//
+TileArchive::TileArchive()
+{
+}
+
+TileArchive::~TileArchive()
+{
+    close();
+}
+
+bool TileArchive::open(const vsg::Path& filename)
+{
+    close();
+
+#if defined(_WIN32)
+    // no memory mapping support on Windows yet so fallback to reading the whole archive into memory
+    std::ifstream fin(filename.string(), std::ios::in | std::ios::binary | std::ios::ate);
+    if (!fin) return false;
+
+    size_t fileSize = static_cast<size_t>(fin.tellg());
+    if (fileSize < sizeof(Header)) return false;
+
+    std::unique_ptr<uint8_t[]> buffer(new uint8_t[fileSize]);
+    fin.seekg(0);
+    fin.read(reinterpret_cast<char*>(buffer.get()), fileSize);
+    if (!fin) return false;
+
+    _begin = buffer.release();
+    _size = fileSize;
+    _mapped = false;
+#else
+    int fd = ::open(filename.string().c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || static_cast<size_t>(fileStat.st_size) < sizeof(Header))
+    {
+        ::close(fd);
+        return false;
+    }
+
+    size_t fileSize = static_cast<size_t>(fileStat.st_size);
+    void* ptr = mmap(nullptr, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+
+    // the mapping keeps a reference to the file so the file descriptor is no longer required
+    ::close(fd);
+
+    if (ptr == MAP_FAILED) return false;
+
+    _begin = static_cast<uint8_t*>(ptr);
+    _size = fileSize;
+    _mapped = true;
+#endif
+
+    Header header;
+    std::memcpy(&header, _begin, sizeof(Header));
+
+    if (std::memcmp(header.magic, s_archiveMagic, sizeof(s_archiveMagic)) == 0 && header.version != VERSION)
+    {
+        vsg::warn("TileArchive::open(", filename, ") unsupported tile archive version ", header.version, ", expected ", VERSION, ", reseed the archive.");
+        close();
+        return false;
+    }
+
+    if (std::memcmp(header.magic, s_archiveMagic, sizeof(s_archiveMagic)) != 0 ||
+        header.entrySize != sizeof(Entry) ||
+        header.indexOffset > _size ||
+        header.numEntries > (_size - header.indexOffset) / sizeof(Entry))
+    {
+        vsg::warn("TileArchive::open(", filename, ") not a valid tile archive.");
+        close();
+        return false;
+    }
+
+    _filename = filename;
+    _entries = reinterpret_cast<const Entry*>(_begin + header.indexOffset);
+    _numEntries = static_cast<size_t>(header.numEntries);
+
+#if !defined(_WIN32)
+    // the index is accessed on every lookup so make sure it's resident
+    size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t indexStart = (header.indexOffset / pageSize) * pageSize;
+    madvise(_begin + indexStart, _size - indexStart, MADV_WILLNEED);
+#endif
+
+    return true;
+}
+
+void TileArchive::close()
+{
+    if (!_begin) return;
+
+#if defined(_WIN32)
+    delete[] _begin;
+#else
+    if (_mapped) munmap(_begin, _size);
+#endif
+
+    _begin = nullptr;
+    _size = 0;
+    _mapped = false;
+    _entries = nullptr;
+    _numEntries = 0;
+}
+
+const TileArchive::Entry* TileArchive::find(uint32_t x, uint32_t y, uint32_t level) const
+{
+    if (!_entries) return nullptr;
+
+    uint64_t key = tileKey(x, y, level);
+    auto end = _entries + _numEntries;
+    auto itr = std::lower_bound(_entries, end, key, [](const Entry& entry, uint64_t value) { return entry.key < value; });
+    if (itr != end && itr->key == key) return itr;
+    return nullptr;
+}
+
+vsg::ref_ptr<vsg::Data> TileArchive::read(uint32_t x, uint32_t y, uint32_t level, vsg::ref_ptr<const vsg::Options> options) const
+{
+    auto entry = find(x, y, level);
+    if (!entry) return {};
+
+    return createData(*entry, options);
+}
+
+std::array<vsg::ref_ptr<vsg::Data>, 4> TileArchive::readChildren(uint32_t x, uint32_t y, uint32_t level, vsg::ref_ptr<const vsg::Options> options) const
+{
+    std::array<vsg::ref_ptr<vsg::Data>, 4> children;
+    if (!_entries) return children;
+
+    // the children of a tile occupy four consecutive keys starting with the Morton code of the top left child
+    uint64_t firstKey = tileKey(x * 2, y * 2, level + 1);
+    uint64_t lastKey = firstKey + 3;
+
+    auto end = _entries + _numEntries;
+    auto first = std::lower_bound(_entries, end, firstKey, [](const Entry& entry, uint64_t value) { return entry.key < value; });
+    auto last = first;
+    while (last != end && last->key <= lastKey) ++last;
+
+    if (first == last) return children;
+
+#if !defined(_WIN32)
+    // payloads of siblings are adjacent so request the whole span in a single read ahead rather than faulting each tile in separately
+    size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t spanStart = (static_cast<size_t>(first->offset) / pageSize) * pageSize;
+    size_t spanEnd = static_cast<size_t>((last - 1)->offset + (last - 1)->size);
+    if (spanEnd > spanStart && spanEnd <= _size) madvise(_begin + spanStart, spanEnd - spanStart, MADV_WILLNEED);
+#endif
+
+    for (auto itr = first; itr != last; ++itr)
+    {
+        children[itr->key - firstKey] = createData(*itr, options);
+    }
+
+    return children;
+}
+
+vsg::ref_ptr<vsg::Data> TileArchive::createData(const Entry& entry, vsg::ref_ptr<const vsg::Options> options) const
+{
+    if (entry.offset > _size || entry.size > _size - entry.offset)
+    {
+        vsg::warn("TileArchive::createData() entry outside of archive ", _filename);
+        return {};
+    }
+
+    uint8_t* ptr = _begin + entry.offset;
+
+    vsg::ref_ptr<vsg::Data> data;
+    if (entry.payloadType == ENCODED)
+    {
+        auto extension = std::string(".") + std::string(entry.extension, strnlen(entry.extension, sizeof(entry.extension)));
+        data = decodeData(ptr, static_cast<size_t>(entry.size), extension, options);
+        if (!data) return {};
+
+        // decoded data doesn't reference the archive so no need to keep it alive
+        setMetaData(entry, *data);
+        return data;
+    }
+
+    vsg::Data::Layout layout;
+    layout.format = static_cast<VkFormat>(entry.format);
+    layout.stride = entry.stride;
+    layout.origin = entry.origin;
+    layout.blockWidth = entry.blockWidth;
+    layout.blockHeight = entry.blockHeight;
+    layout.maxNumMipmaps = entry.maxNumMipmaps;
+    layout.allocatorType = vsg::ALLOCATOR_TYPE_NO_DELETE;
+
+    if (entry.blockWidth > 1 || entry.blockHeight > 1)
+    {
+        // block compressed formats are only distinguished by their block size
+        switch (entry.stride)
+        {
+        case (8): data = createArray2D<vsg::block64Array2D>(entry, ptr, layout); break;
+        case (16): data = createArray2D<vsg::block128Array2D>(entry, ptr, layout); break;
+        default: break;
+        }
+    }
+    else
+    {
+        // the value type follows the format so signed and floating point data, such as float terrain, isn't read back as unsigned values
+        data = dispatchImageFormat(layout.format, [&](auto rasterType) -> vsg::ref_ptr<vsg::Data> {
+            using R = decltype(rasterType);
+            if (sizeof(typename R::value_type) != entry.stride) return {};
+            return createArray2D<typename R::array_type>(entry, ptr, layout);
+        });
+
+        if (!data)
+        {
+            // formats without a RasterType, half floats are held as ushorts as the Array2D types have no half float value type
+            switch (layout.format)
+            {
+            case (VK_FORMAT_R16_SFLOAT): data = createArray2D<vsg::ushortArray2D>(entry, ptr, layout); break;
+            case (VK_FORMAT_R16G16_SFLOAT): data = createArray2D<vsg::usvec2Array2D>(entry, ptr, layout); break;
+            case (VK_FORMAT_R16G16B16_SFLOAT): data = createArray2D<vsg::usvec3Array2D>(entry, ptr, layout); break;
+            case (VK_FORMAT_R16G16B16A16_SFLOAT): data = createArray2D<vsg::usvec4Array2D>(entry, ptr, layout); break;
+            case (VK_FORMAT_R8_SRGB): data = createArray2D<vsg::ubyteArray2D>(entry, ptr, layout); break;
+            case (VK_FORMAT_R8G8_SRGB): data = createArray2D<vsg::ubvec2Array2D>(entry, ptr, layout); break;
+            case (VK_FORMAT_R8G8B8_SRGB):
+            case (VK_FORMAT_B8G8R8_UNORM):
+            case (VK_FORMAT_B8G8R8_SRGB): data = createArray2D<vsg::ubvec3Array2D>(entry, ptr, layout); break;
+            case (VK_FORMAT_R8G8B8A8_SRGB):
+            case (VK_FORMAT_B8G8R8A8_UNORM):
+            case (VK_FORMAT_B8G8R8A8_SRGB): data = createArray2D<vsg::ubvec4Array2D>(entry, ptr, layout); break;
+            default: break;
+            }
+
+            // guard against an index whose stride doesn't match it's format
+            if (data && data->valueSize() != entry.stride) data = {};
+        }
+    }
+
+    if (!data)
+    {
+        vsg::warn("TileArchive::createData() unsupported payload format ", entry.format, " with stride ", entry.stride, " in ", _filename);
+        return {};
+    }
+
+    // the data references the mapped memory so keep the archive alive for as long as the data is
+    data->setObject("TileArchive", vsg::ref_ptr<vsg::Object>(const_cast<TileArchive*>(this)));
+    setMetaData(entry, *data);
+
+    return data;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  TileArchiveBuilder
+//
+void TileArchiveBuilder::add(uint32_t x, uint32_t y, uint32_t level, vsg::ref_ptr<vsg::Data> data)
+{
+    if (!data || !data->dataPointer()) return;
+
+    _tiles.push_back(Tile{tileKey(x, y, level), data, {}});
+}
+
+void TileArchiveBuilder::add(uint32_t x, uint32_t y, uint32_t level, vsg::ref_ptr<vsg::ubyteArray> encoded, const std::string& extension)
+{
+    if (!encoded || encoded->dataSize() == 0) return;
+
+    std::string ext = (!extension.empty() && extension[0] == '.') ? extension.substr(1) : extension;
+    if (ext.empty() || ext.size() > sizeof(TileArchive::Entry::extension))
+    {
+        vsg::warn("TileArchiveBuilder::add() unsupported extension ", extension);
+        return;
+    }
+
+    _tiles.push_back(Tile{tileKey(x, y, level), encoded, ext});
+}
+
+bool TileArchiveBuilder::write(const vsg::Path& filename) const
+{
+    std::vector<const Tile*> sorted;
+    sorted.reserve(_tiles.size());
+    for (auto& tile : _tiles) sorted.push_back(&tile);
+
+    // stable so that when a tile is added more than once the last entry added wins after the duplicate removal below
+    std::stable_sort(sorted.begin(), sorted.end(), [](const Tile* lhs, const Tile* rhs) { return lhs->key < rhs->key; });
+    for (size_t i = 1; i < sorted.size();)
+    {
+        if (sorted[i - 1]->key == sorted[i]->key)
+            sorted.erase(sorted.begin() + (i - 1));
+        else
+            ++i;
+    }
+
+    auto writer = TileArchiveWriter::create();
+    if (!writer->open(filename)) return false;
+
+    for (auto tile : sorted)
+    {
+        uint32_t x, y;
+        inverseMorton2D(tile->key & 0x03ffffffffffffffull, x, y);
+        uint32_t level = static_cast<uint32_t>(tile->key >> 58);
+
+        bool result = tile->extension.empty() ? writer->add(x, y, level, tile->data) : writer->add(x, y, level, tile->data.cast<vsg::ubyteArray>(), tile->extension);
+        if (!result) return false;
+    }
+
+    return writer->close();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  TileArchiveWriter
+//
+TileArchiveWriter::TileArchiveWriter()
+{
+}
+
+TileArchiveWriter::~TileArchiveWriter()
+{
+    if (_fout.is_open()) close();
+}
+
+bool TileArchiveWriter::open(const vsg::Path& filename)
+{
+    if (_fout.is_open()) close();
+
+    _filename = filename;
+    _offset = 0;
+    _entries.clear();
+
+    _fout.open(filename.string(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!_fout)
+    {
+        vsg::warn("TileArchiveWriter::open() unable to open ", filename);
+        return false;
+    }
+
+    // write a placeholder header that is filled in by close() once the index offset is known
+    TileArchive::Header header;
+    std::memset(&header, 0, sizeof(header));
+    _writeAligned(&header, sizeof(header));
+
+    return true;
+}
+
+bool TileArchiveWriter::add(uint32_t x, uint32_t y, uint32_t level, vsg::ref_ptr<vsg::Data> data)
+{
+    if (!data || !data->dataPointer()) return false;
+
+    return _add(tileKey(x, y, level), *data, {});
+}
+
+bool TileArchiveWriter::add(uint32_t x, uint32_t y, uint32_t level, vsg::ref_ptr<vsg::ubyteArray> encoded, const std::string& extension)
+{
+    if (!encoded || encoded->dataSize() == 0) return false;
+
+    std::string ext = (!extension.empty() && extension[0] == '.') ? extension.substr(1) : extension;
+    if (ext.empty() || ext.size() > sizeof(TileArchive::Entry::extension))
+    {
+        vsg::warn("TileArchiveWriter::add() unsupported extension ", extension);
+        return false;
+    }
+
+    return _add(tileKey(x, y, level), *encoded, ext);
+}
+
+uint64_t TileArchiveWriter::_writeAligned(const void* ptr, uint64_t size)
+{
+    const char padding[s_payloadAlignment] = {};
+
+    uint64_t start = alignedOffset(_offset);
+    _fout.write(padding, static_cast<std::streamsize>(start - _offset));
+    _fout.write(reinterpret_cast<const char*>(ptr), static_cast<std::streamsize>(size));
+    _offset = start + size;
+    return start;
+}
+
+bool TileArchiveWriter::_add(uint64_t key, const vsg::Data& data, const std::string& extension)
+{
+    if (!_fout.is_open()) return false;
+
+    // the index is searched by key so must be sorted
+    if (!_entries.empty() && key <= _entries.back().key)
+    {
+        vsg::warn("TileArchiveWriter::add() tiles must be added in ascending tileKey order, ", _filename);
+        return false;
+    }
+
+    auto layout = data.getLayout();
+
+    TileArchive::Entry entry;
+    std::memset(&entry, 0, sizeof(entry));
+    entry.key = key;
+    entry.size = data.dataSize();
+    entry.offset = _writeAligned(data.dataPointer(), entry.size);
+
+    if (extension.empty())
+    {
+        entry.payloadType = TileArchive::RAW;
+        entry.format = static_cast<uint32_t>(layout.format);
+        entry.width = data.width();
+        entry.height = data.height();
+        entry.stride = static_cast<uint16_t>(data.valueSize());
+        entry.origin = layout.origin;
+        entry.blockWidth = layout.blockWidth;
+        entry.blockHeight = layout.blockHeight;
+        entry.maxNumMipmaps = layout.maxNumMipmaps;
+    }
+    else
+    {
+        entry.payloadType = TileArchive::ENCODED;
+        std::memcpy(entry.extension, extension.data(), extension.size());
+    }
+
+    // the meta data, such as the "offset" and "scale" of quantized terrain, is needed to interpret the payload so is held alongside it
+    getMetaData(data, entry);
+
+    _entries.push_back(entry);
+
+    return static_cast<bool>(_fout);
+}
+
+bool TileArchiveWriter::close()
+{
+    if (!_fout.is_open()) return false;
+
+    TileArchive::Header header;
+    std::memcpy(header.magic, s_archiveMagic, sizeof(s_archiveMagic));
+    header.version = TileArchive::VERSION;
+    header.entrySize = sizeof(TileArchive::Entry);
+    header.numEntries = _entries.size();
+    header.indexOffset = _writeAligned(_entries.data(), _entries.size() * sizeof(TileArchive::Entry));
+
+    _fout.seekp(0);
+    _fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    bool result = static_cast<bool>(_fout);
+    _fout.close();
+    _entries.clear();
+
+    if (!result) vsg::warn("TileArchiveWriter::close() failed writing ", _filename);
+    return result;
+}
@@ -1,11 +1,11 @@
+#include <vsgGIS/MosaicIndex.h>
 #include <vsgGIS/TileDatabase.h>
+#include <vsgGIS/gdal_utils.h>
+#include <vsgGIS/raster_utils.h>
 
 #include <vsg/io/Logger.h>
 #include <vsg/io/Options.h>
 
-#include "shaders/simple_tile_frag.cpp"
-#include "shaders/simple_tile_vert.cpp"
-
 using namespace vsgGIS;
 
 bool vsgGIS::init()
@@ -18,6 +18,60 @@ vsg::RegisterWithObjectFactoryProxy<vsgGIS::TileDatabaseSettings> s_Register_Til
 vsg::RegisterWithObjectFactoryProxy<vsgGIS::TileDatabase> s_Register_TileDatabase;
 vsg::RegisterWithObjectFactoryProxy<vsgGIS::TileReader> s_Register_TileReader;
 
+namespace
+{
+    // coordinate reference system that tile locations are reprojected to when computing latitude, longitude and altitude
+    const std::string s_geographicProjection("EPSG:4326");
+
+    bool isSphericalMercator(const std::string& projection)
+    {
+        return projection == "EPSG:3857" || projection == "spherical-mercator";
+    }
+
+    // number of rows and columns of the full resolution grid of a tile's mesh and of it's heights, 2^n + 1 as required by TerrainMeshBuilder
+    constexpr uint32_t s_tileGridSize = 33;
+
+    // mark static tile data so the compile traversal drops it's reference once the data has been transferred to the GPU.
+    // Only the reference held by the scene graph is dropped, so data also held by the FetchCoalescer cache remains available to recreate tiles from.
+    void releaseAfterTransfer(const vsg::DataList& dataList)
+    {
+        for (auto& data : dataList)
+        {
+            if (data) data->getLayout().dataVariance = vsg::STATIC_DATA_UNREF_AFTER_TRANSFER;
+        }
+    }
+
+    // run a function on a worker thread, counting down the latch on completion even if the function throws, so the reading thread isn't left waiting
+    struct BuildTileOperation : public vsg::Inherit<vsg::Operation, BuildTileOperation>
+    {
+        BuildTileOperation(std::function<void()> in_build, vsg::ref_ptr<vsg::Latch> in_latch) :
+            build(in_build),
+            latch(in_latch) {}
+
+        std::function<void()> build;
+        vsg::ref_ptr<vsg::Latch> latch;
+
+        void run() override
+        {
+            struct CountDown
+            {
+                vsg::Latch& latch;
+                ~CountDown() { latch.count_down(); }
+            } countDown{*latch};
+
+            // an exception escaping run() would terminate the worker thread's process
+            try
+            {
+                build();
+            }
+            catch (const std::exception& e)
+            {
+                vsg::warn("BuildTileOperation::run() exception building tile: ", e.what());
+            }
+        }
+    };
+} // namespace
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
 //  TileDatabaseSettings
@@ -35,6 +89,23 @@ void TileDatabaseSettings::read(vsg::Input& input)
     input.read("imageLayer", imageLayer);
     input.read("terrainLayer", terrainLayer);
     input.read("mipmapLevelsHint", mipmapLevelsHint);
+
+    // fields added since the original settings are appended after settingsVersion, settings written before it was added read as version 0 and keep the defaults
+    uint32_t settingsVersion = 0;
+    input.read("settingsVersion", settingsVersion);
+    if (settingsVersion >= 1)
+    {
+        input.read("reprojectionErrorThreshold", reprojectionErrorThreshold);
+        input.read("terrainMeshError", terrainMeshError);
+        input.read("compactVertices", compactVertices);
+        input.read("prefetchLookAheadTime", prefetchLookAheadTime);
+        input.read("prefetchCacheSize", prefetchCacheSize);
+        input.read("tileMemoryBudget", tileMemoryBudget);
+        input.read("gdalCacheBudget", gdalCacheBudget);
+        input.read("releaseDataAfterTransfer", releaseDataAfterTransfer);
+        input.read("targetFrameTime", targetFrameTime);
+        input.readObjects("overlayLayers", overlayLayers);
+    }
 }
 
 void TileDatabaseSettings::write(vsg::Output& output) const
@@ -50,6 +121,145 @@ void TileDatabaseSettings::write(vsg::Output& output) const
     output.write("imageLayer", imageLayer);
     output.write("terrainLayer", terrainLayer);
     output.write("mipmapLevelsHint", mipmapLevelsHint);
+
+    output.write("settingsVersion", VERSION);
+    output.write("reprojectionErrorThreshold", reprojectionErrorThreshold);
+    output.write("terrainMeshError", terrainMeshError);
+    output.write("compactVertices", compactVertices);
+    output.write("prefetchLookAheadTime", prefetchLookAheadTime);
+    output.write("prefetchCacheSize", prefetchCacheSize);
+    output.write("tileMemoryBudget", tileMemoryBudget);
+    output.write("gdalCacheBudget", gdalCacheBudget);
+    output.write("releaseDataAfterTransfer", releaseDataAfterTransfer);
+    output.write("targetFrameTime", targetFrameTime);
+    output.writeObjects("overlayLayers", overlayLayers);
+}
+
+vsg::dvec3 TileDatabaseSettings::computeLatitudeLongitudeAltitude(const vsg::dvec3& src) const
+{
+    if (isSphericalMercator(projection))
+    {
+        double n = 2.0 * vsg::radians(src.y);
+        double adjustedLatitude = vsg::degrees(atan(0.5 * (exp(n) - exp(-n))));
+        return vsg::dvec3(adjustedLatitude, src.x, src.z);
+    }
+    else if (auto reprojection = _getReprojections()->toGeographic)
+    {
+        vsg::dvec3 longitudeLatitudeAltitude = src;
+        reprojection->transform(longitudeLatitudeAltitude);
+        return vsg::dvec3(longitudeLatitudeAltitude.y, longitudeLatitudeAltitude.x, longitudeLatitudeAltitude.z);
+    }
+    else
+    {
+        return vsg::dvec3(src.y, src.x, src.z);
+    }
+}
+
+vsg::dvec3 TileDatabaseSettings::computeTileLocation(const vsg::dvec3& latitudeLongitudeAltitude) const
+{
+    if (isSphericalMercator(projection))
+    {
+        double adjustedLatitude = vsg::degrees(0.5 * asinh(tan(vsg::radians(latitudeLongitudeAltitude.x))));
+        return vsg::dvec3(latitudeLongitudeAltitude.y, adjustedLatitude, latitudeLongitudeAltitude.z);
+    }
+    else if (auto reprojection = _getReprojections()->fromGeographic)
+    {
+        vsg::dvec3 location(latitudeLongitudeAltitude.y, latitudeLongitudeAltitude.x, latitudeLongitudeAltitude.z);
+        reprojection->transform(location);
+        return location;
+    }
+    else
+    {
+        return vsg::dvec3(latitudeLongitudeAltitude.y, latitudeLongitudeAltitude.x, latitudeLongitudeAltitude.z);
+    }
+}
+
+bool TileDatabaseSettings::computeTileCoordinates(const vsg::dvec3& location, uint32_t level, uint32_t& x, uint32_t& y) const
+{
+    if (location.x < extents.min.x || location.x > extents.max.x || location.y < extents.min.y || location.y > extents.max.y) return false;
+
+    double multiplier = pow(0.5, double(level));
+    double tileWidth = multiplier * (extents.max.x - extents.min.x) / double(noX);
+    double tileHeight = multiplier * (extents.max.y - extents.min.y) / double(noY);
+
+    double fx = (location.x - extents.min.x) / tileWidth;
+    double fy = originTopLeft ? (extents.max.y - location.y) / tileHeight : (location.y - extents.min.y) / tileHeight;
+
+    // locations on the maximum edges belong to the last tile
+    x = std::min(static_cast<uint32_t>(fx), (noX << level) - 1);
+    y = std::min(static_cast<uint32_t>(fy), (noY << level) - 1);
+    return true;
+}
+
+std::shared_ptr<const TileDatabaseSettings::Reprojections> TileDatabaseSettings::_getReprojections() const
+{
+    auto reprojections = std::atomic_load(&_reprojections);
+    if (reprojections && reprojections->projection == projection) return reprojections;
+
+    // threads that resolve the same projection concurrently get the same Reprojection::get(..) results, so whichever store lands last is equivalent
+    auto resolved = std::make_shared<Reprojections>();
+    resolved->projection = projection;
+    if (!projection.empty() && !isSphericalMercator(projection))
+    {
+        auto toGeographic = Reprojection::get(projection, s_geographicProjection);
+        if (toGeographic->valid() && !toGeographic->identity())
+        {
+            resolved->toGeographic = toGeographic;
+            resolved->fromGeographic = Reprojection::get(s_geographicProjection, projection);
+        }
+    }
+
+    reprojections = resolved;
+    std::atomic_store(&_reprojections, reprojections);
+    return reprojections;
+}
+
+vsg::ref_ptr<Reprojection> TileDatabaseSettings::getReprojection() const
+{
+    return _getReprojections()->toGeographic;
+}
+
+vsg::ref_ptr<Reprojection> TileDatabaseSettings::getInverseReprojection() const
+{
+    return _getReprojections()->fromGeographic;
+}
+
+vsg::Path TileDatabaseSettings::getTilePath(const vsg::Path& layer, uint32_t x, uint32_t y, uint32_t level) const
+{
+    auto replace = [](vsg::Path& path, const std::string& match, uint32_t value) {
+        std::stringstream sstr;
+        sstr << value;
+        auto levelPos = path.find(match);
+        if (levelPos != vsg::Path::npos) path.replace(levelPos, match.length(), sstr.str());
+    };
+
+    vsg::Path path = layer;
+    replace(path, "{z}", level);
+    replace(path, "{x}", x);
+    replace(path, "{y}", y);
+
+    return path;
+}
+
+vsg::dbox TileDatabaseSettings::computeTileExtents(uint32_t x, uint32_t y, uint32_t level) const
+{
+    double multiplier = pow(0.5, double(level));
+    double tileWidth = multiplier * (extents.max.x - extents.min.x) / double(noX);
+    double tileHeight = multiplier * (extents.max.y - extents.min.y) / double(noY);
+
+    vsg::dbox tile_extents;
+    if (originTopLeft)
+    {
+        vsg::dvec3 origin(extents.min.x, extents.max.y, extents.min.z);
+        tile_extents.min = origin + vsg::dvec3(double(x) * tileWidth, -double(y + 1) * tileHeight, 0.0);
+        tile_extents.max = origin + vsg::dvec3(double(x + 1) * tileWidth, -double(y) * tileHeight, 1.0);
+    }
+    else
+    {
+        tile_extents.min = extents.min + vsg::dvec3(double(x) * tileWidth, double(y) * tileHeight, 0.0);
+        tile_extents.max = extents.min + vsg::dvec3(double(x + 1) * tileWidth, double(y + 1) * tileHeight, 1.0);
+    }
+    return tile_extents;
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -87,9 +297,44 @@ bool TileDatabase::readDatabase(vsg::ref_ptr<const vsg::Options> options)
 
     child = vsg::read_cast<vsg::Node>("root.tile", local_options);
 
+    elevationIndex = tileReader->elevationIndex;
+    memoryMonitor = tileReader->memoryMonitor;
+    scheduler = tileReader->scheduler;
+    lodController = tileReader->lodController;
+
+    if (settings->prefetchLookAheadTime > 0.0 && tileReader->fetchCoalescer)
+    {
+        // prefetched tiles are held in the FetchCoalescer cache until they are requested
+        size_t cacheSize = size_t(settings->prefetchCacheSize) * 1024 * 1024;
+        auto& fetchCoalescer = tileReader->fetchCoalescer;
+        size_t maxCacheSize = fetchCoalescer->maxCacheSize.load();
+        while (maxCacheSize < cacheSize && !fetchCoalescer->maxCacheSize.compare_exchange_weak(maxCacheSize, cacheSize)) {}
+
+        prefetcher = TilePrefetcher::create(tileReader, local_options);
+        prefetcher->lookAheadTime = settings->prefetchLookAheadTime;
+    }
+
     return child.valid();
 }
 
+ElevationIndex::Result TileDatabase::queryHeight(double latitude, double longitude) const
+{
+    if (!elevationIndex) return {};
+    return elevationIndex->query(latitude, longitude);
+}
+
+void TileDatabase::queryHeights(size_t count, const vsg::dvec2* latitudeLongitudes, ElevationIndex::Result* results) const
+{
+    if (elevationIndex)
+    {
+        elevationIndex->query(count, latitudeLongitudes, results);
+    }
+    else
+    {
+        std::fill(results, results + count, ElevationIndex::Result{});
+    }
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
 //  TileDatabase
@@ -108,54 +353,24 @@ void TileReader::write(vsg::Output& output) const
 
 vsg::dvec3 TileReader::computeLatitudeLongitudeAltitude(const vsg::dvec3& src) const
 {
-    if (settings->projection == "EPSG:3857" || settings->projection == "spherical-mercator")
-    {
-        double n = 2.0 * vsg::radians(src.y);
-        double adjustedLatitude = vsg::degrees(atan(0.5 * (exp(n) - exp(-n))));
-        return vsg::dvec3(adjustedLatitude, src.x, src.z);
-    }
-    else
-    {
-        return vsg::dvec3(src.y, src.x, src.z);
-    }
+    return settings->computeLatitudeLongitudeAltitude(src);
 }
 
 vsg::dbox TileReader::computeTileExtents(uint32_t x, uint32_t y, uint32_t level) const
 {
-    double multiplier = pow(0.5, double(level));
-    double tileWidth = multiplier * (settings->extents.max.x - settings->extents.min.x) / double(settings->noX);
-    double tileHeight = multiplier * (settings->extents.max.y - settings->extents.min.y) / double(settings->noY);
-
-    vsg::dbox tile_extents;
-    if (settings->originTopLeft)
-    {
-        vsg::dvec3 origin(settings->extents.min.x, settings->extents.max.y, settings->extents.min.z);
-        tile_extents.min = origin + vsg::dvec3(double(x) * tileWidth, -double(y + 1) * tileHeight, 0.0);
-        tile_extents.max = origin + vsg::dvec3(double(x + 1) * tileWidth, -double(y) * tileHeight, 1.0);
-    }
-    else
-    {
-        tile_extents.min = settings->extents.min + vsg::dvec3(double(x) * tileWidth, double(y) * tileHeight, 0.0);
-        tile_extents.max = settings->extents.min + vsg::dvec3(double(x + 1) * tileWidth, double(y + 1) * tileHeight, 1.0);
-    }
-    return tile_extents;
+    return settings->computeTileExtents(x, y, level);
 }
 
 vsg::Path TileReader::getTilePath(const vsg::Path& src, uint32_t x, uint32_t y, uint32_t level) const
 {
-    auto replace = [](vsg::Path& path, const std::string& match, uint32_t value) {
-        std::stringstream sstr;
-        sstr << value;
-        auto levelPos = path.find(match);
-        if (levelPos != vsg::Path::npos) path.replace(levelPos, match.length(), sstr.str());
-    };
+    return settings->getTilePath(src, x, y, level);
+}
 
-    vsg::Path path = src;
-    replace(path, "{z}", level);
-    replace(path, "{x}", x);
-    replace(path, "{y}", y);
+void TileReader::registerTile(uint32_t x, uint32_t y, uint32_t level, vsg::Node* tile) const
+{
+    if (!elevationIndex || !tile) return;
 
-    return path;
+    if (auto heights = tile->getObject<vsg::floatArray2D>("Heights")) elevationIndex->add(x, y, level, vsg::ref_ptr<const vsg::floatArray2D>(heights), tile);
 }
 
 vsg::ref_ptr<vsg::Object> TileReader::read(const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options) const
@@ -177,8 +392,162 @@ vsg::ref_ptr<vsg::Object> TileReader::read(const vsg::Path& filename, vsg::ref_p
 
         vsg::debug("read(", filename, ") -> tile_info = ", tile_info, ", x = ", x, ", y = ", y, ", z = ", lod);
 
-        return read_subtile(x, y, lod, options);
+        // wait for the request's turn, abandoning it if the camera has moved on while it was queued
+        uint64_t key = tileKey(x, y, lod);
+        if (scheduler && !scheduler->begin(key)) return {};
+
+        auto subtiles = read_subtile(x, y, lod, options);
+
+        if (scheduler) scheduler->end(key, subtiles.valid());
+        return subtiles;
+    }
+}
+
+size_t TileReader::prefetch(uint32_t x, uint32_t y, uint32_t level, vsg::ref_ptr<const vsg::Options> options) const
+{
+    if (!fetchCoalescer || fetchCoalescer->maxCacheSize == 0) return 0;
+
+    // tiles held in archives are memory mapped so don't need prefetching into the cache
+    vsg::Paths paths;
+    auto request = [&](const vsg::Path& layer, const vsg::ref_ptr<TileArchive>& archive) {
+        if (layer.empty() || archive) return;
+
+        auto path = getTilePath(layer, x, y, level);
+        if (!fetchCoalescer->cached(path, options)) paths.push_back(path);
+    };
+
+    // mosaic tiles are reprojected from their source datasets rather than read from tile files
+    if (!imageMosaic) request(settings->imageLayer, imageArchive);
+    request(settings->terrainLayer, terrainArchive);
+
+    for (size_t i = 0; i < settings->overlayLayers.size(); ++i)
+    {
+        auto& overlayLayer = settings->overlayLayers[i];
+        if (overlayLayer && overlayLayer->activeAt(level)) request(overlayLayer->path, i < overlayArchives.size() ? overlayArchives[i] : vsg::ref_ptr<TileArchive>());
+    }
+
+    if (paths.empty()) return 0;
+
+    size_t bytes = 0;
+    for (auto& [path, object] : fetchCoalescer->read(paths, options))
+    {
+        if (auto data = object.cast<vsg::Data>()) bytes += data->dataSize();
+    }
+    return bytes;
+}
+
+void TileReader::readTiles(std::vector<TileData>& tiles, uint32_t level, vsg::ref_ptr<const vsg::Options> options) const
+{
+    bool hasTerrain = !settings->terrainLayer.empty();
+    auto& overlayLayers = settings->overlayLayers;
+
+    // layers that a path is requested for, overlays use their index in overlayLayers
+    constexpr int imageLayer = -2;
+    constexpr int terrainLayer = -1;
+
+    // paths of the tiles that aren't in archives, mapped to the index of the tile and the layer it's for
+    vsg::Paths paths;
+    std::multimap<vsg::Path, std::pair<size_t, int>> pathToTile;
+
+    auto request = [&](const vsg::Path& layer, size_t index, int layerIndex) {
+        auto path = getTilePath(layer, tiles[index].x, tiles[index].y, level);
+        if (pathToTile.count(path) == 0) paths.push_back(path);
+        pathToTile.emplace(path, std::make_pair(index, layerIndex));
+    };
+
+    for (size_t i = 0; i < tiles.size(); ++i)
+    {
+        auto& tile = tiles[i];
+        if (!tile.image)
+        {
+            if (imageArchive)
+                tile.image = imageArchive->read(tile.x, tile.y, level, options);
+            else if (imageMosaic)
+                tile.image = imageMosaic->createImage(*settings, tile.x, tile.y, level, mosaicTileSize, mosaicTileSize, *datasetPool);
+            else
+                request(settings->imageLayer, i, imageLayer);
+        }
+
+        if (hasTerrain && !tile.terrain)
+        {
+            if (terrainArchive)
+                tile.terrain = terrainArchive->read(tile.x, tile.y, level, options);
+            else
+                request(settings->terrainLayer, i, terrainLayer);
+        }
+
+        // overlays are fetched in the same batch as the image and terrain
+        tile.overlays.resize(overlayLayers.size());
+        for (size_t layerIndex = 0; layerIndex < overlayLayers.size(); ++layerIndex)
+        {
+            auto& overlayLayer = overlayLayers[layerIndex];
+            if (tile.overlays[layerIndex] || !overlayLayer || !overlayLayer->activeAt(level)) continue;
+
+            if (layerIndex < overlayArchives.size() && overlayArchives[layerIndex])
+                tile.overlays[layerIndex] = overlayArchives[layerIndex]->read(tile.x, tile.y, level, options);
+            else
+                request(overlayLayer->path, i, static_cast<int>(layerIndex));
+        }
+    }
+
+    if (!paths.empty())
+    {
+        // the paths are fetched concurrently, sharing the reads already in flight for other requests
+        auto pathObjects = fetchCoalescer ? fetchCoalescer->read(paths, options) : vsg::read(paths, options);
+        for (auto& [path, object] : pathObjects)
+        {
+            auto data = object.cast<vsg::Data>();
+            if (!data) continue;
+
+            auto range = pathToTile.equal_range(path);
+            for (auto itr = range.first; itr != range.second; ++itr)
+            {
+                auto& [index, layerIndex] = itr->second;
+                if (layerIndex == terrainLayer)
+                    tiles[index].terrain = data;
+                else if (layerIndex == imageLayer)
+                    tiles[index].image = data;
+                else
+                    tiles[index].overlays[layerIndex] = data;
+            }
+        }
+    }
+
+    for (auto& tile : tiles) compositeOverlays(tile, level);
+}
+
+bool TileReader::compositeOverlays(TileData& tile, uint32_t level) const
+{
+    if (!tile.image || isNoDataOnly(*tile.image)) return false;
+
+    // the fetched image may be shared through the FetchCoalescer cache or mapped from an archive, so the overlays are composited onto a copy
+    vsg::ref_ptr<vsg::Data> composite;
+    for (size_t layerIndex = 0; layerIndex < tile.overlays.size(); ++layerIndex)
+    {
+        auto& overlay = tile.overlays[layerIndex];
+        auto& overlayLayer = settings->overlayLayers[layerIndex];
+        if (!overlay || !overlayLayer || !overlayLayer->activeAt(level) || isNoDataOnly(*overlay)) continue;
+
+        if (!composite)
+        {
+            composite = createCompositeImage(*tile.image);
+            if (!composite)
+            {
+                vsg::debug("TileReader::compositeOverlays() unable to composite onto image format ", tile.image->getLayout().format);
+                return false;
+            }
+        }
+
+        if (!compositeImage(*composite, *overlay, overlayLayer->opacity, overlayLayer->blendMode))
+        {
+            vsg::debug("TileReader::compositeOverlays() unable to composite overlay ", overlayLayer->path, " of format ", overlay->getLayout().format);
+        }
     }
+
+    if (!composite) return false;
+
+    tile.image = composite;
+    return true;
 }
 
 vsg::ref_ptr<vsg::Object> TileReader::read_root(vsg::ref_ptr<const vsg::Options> options) const
@@ -186,36 +555,41 @@ vsg::ref_ptr<vsg::Object> TileReader::read_root(vsg::ref_ptr<const vsg::Options>
     auto group = createRoot();
 
     uint32_t lod = 0;
+    std::vector<TileData> tiles;
     for (uint32_t y = 0; y < settings->noY; ++y)
     {
         for (uint32_t x = 0; x < settings->noX; ++x)
         {
-            auto imagePath = getTilePath(settings->imageLayer, x, y, lod);
-            //auto terrainPath = getTilePath(terrainLayer, x, y, lod);
+            tiles.push_back(TileData{x, y, {}, {}});
+        }
+    }
 
-            auto imageTile = vsg::read_cast<vsg::Data>(imagePath, options);
-            //auto terrainTile = vsg::read(terrainPath, options);
+    // fetch the imagery and terrain of all the root tiles together
+    readTiles(tiles, lod, options);
 
-            if (imageTile)
+    for (auto& tileData : tiles)
+    {
+        auto& imageTile = tileData.image;
+        if (imageTile && !isNoDataOnly(*imageTile))
+        {
+            auto tile_extents = computeTileExtents(tileData.x, tileData.y, lod);
+            TileBounds bounds;
+            auto tile = createTile(tile_extents, imageTile, tileData.terrain, bounds);
+            if (tile)
             {
-                auto tile_extents = computeTileExtents(x, y, lod);
-                auto tile = createTile(tile_extents, imageTile);
-                if (tile)
-                {
-                    vsg::ComputeBounds computeBound;
-                    tile->accept(computeBound);
-                    auto& bb = computeBound.bounds;
-                    vsg::dsphere bound((bb.min.x + bb.max.x) * 0.5, (bb.min.y + bb.max.y) * 0.5, (bb.min.z + bb.max.z) * 0.5, vsg::length(bb.max - bb.min) * 0.5);
-
-                    auto plod = vsg::PagedLOD::create();
-                    plod->bound = bound;
-                    plod->children[0] = vsg::PagedLOD::Child{0.25, {}};  // external child visible when it's bound occupies more than 1/4 of the height of the window
-                    plod->children[1] = vsg::PagedLOD::Child{0.0, tile}; // visible always
-                    plod->filename = vsg::make_string(x, " ", y, " 0.tile");
-                    plod->options = options;
-
-                    group->addChild(plod);
-                }
+                registerTile(tileData.x, tileData.y, lod, tile);
+
+                auto plod = vsg::PagedLOD::create();
+                plod->bound = bounds.sphere;
+                plod->children[0] = vsg::PagedLOD::Child{settings->lodTransitionScreenHeightRatio, {}}; // external child visible when it's bound occupies more than lodTransitionScreenHeightRatio of the height of the window
+                plod->children[1] = vsg::PagedLOD::Child{0.0, tile};                                    // visible always
+                plod->filename = vsg::make_string(tileData.x, " ", tileData.y, " 0.tile");
+                plod->options = options;
+
+                if (scheduler) scheduler->track(tileKey(tileData.x, tileData.y, lod), plod);
+                if (lodController) lodController->track(tileKey(tileData.x, tileData.y, lod), plod);
+
+                group->addChild(plod);
             }
         }
     }
@@ -251,58 +625,113 @@ vsg::ref_ptr<vsg::Object> TileReader::read_subtile(uint32_t x, uint32_t y, uint3
 
     auto group = vsg::Group::create();
 
-    struct TileID
-    {
-        uint32_t local_x;
-        uint32_t local_y;
-    };
-
-    vsg::Paths tiles;
-    std::map<vsg::Path, TileID> pathToTileID;
-
     uint32_t subtile_x = x * 2;
     uint32_t subtile_y = y * 2;
     uint32_t local_lod = lod + 1;
+
+    std::vector<TileData> tiles;
     for (uint32_t dy = 0; dy < 2; ++dy)
     {
         for (uint32_t dx = 0; dx < 2; ++dx)
         {
-            uint32_t local_x = subtile_x + dx;
-            uint32_t local_y = subtile_y + dy;
-            auto tilePath = getTilePath(settings->imageLayer, local_x, local_y, local_lod);
-            tiles.push_back(tilePath);
-            pathToTileID[tilePath] = TileID{local_x, local_y};
+            tiles.push_back(TileData{subtile_x + dx, subtile_y + dy, {}, {}});
         }
     }
 
-    auto pathObjects = vsg::read(tiles, options);
+    uint64_t key = tileKey(x, y, lod);
+    if (scheduler && !scheduler->proceed(key, TileRequestScheduler::FETCH)) return {};
+
+    if (imageArchive)
+    {
+        // children are adjacent in the archive so are fetched together in Morton order, which matches the order of tiles
+        auto children = imageArchive->readChildren(x, y, lod, options);
+        for (uint32_t i = 0; i < 4; ++i) tiles[i].image = children[i];
+    }
+
+    // fetch the imagery and terrain of the 4 subtiles together, rather than in sequential rounds
+    readTiles(tiles, local_lod, options);
+
+    uint32_t numImageTiles = 0;
+    for (auto& tileData : tiles)
+    {
+        if (tileData.image) ++numImageTiles;
+    }
+
+    // tiles holding only NoData are valid but don't need any geometry creating for them
+    uint32_t numNoDataTiles = 0;
 
-    if (pathObjects.size() == 4)
+    if (scheduler && !scheduler->proceed(key, TileRequestScheduler::BUILD)) return {};
+
+    if (numImageTiles == 4)
     {
-        for (auto& [tilePath, object] : pathObjects)
+        // build the subtiles concurrently, collecting the results by index so the children are added in a deterministic order
+        std::array<vsg::ref_ptr<vsg::Node>, 4> builtTiles;
+        std::array<TileBounds, 4> builtBounds;
+        std::array<bool, 4> noDataTiles{};
+
+        auto buildTile = [&](size_t i) {
+            auto& tileData = tiles[i];
+            if (isNoDataOnly(*tileData.image))
+            {
+                noDataTiles[i] = true;
+                return;
+            }
+
+            auto tile_extents = computeTileExtents(tileData.x, tileData.y, local_lod);
+            builtTiles[i] = createTile(tile_extents, tileData.image, tileData.terrain, builtBounds[i]);
+            if (builtTiles[i]) registerTile(tileData.x, tileData.y, local_lod, builtTiles[i]);
+        };
+
+        if (buildThreads)
         {
-            auto& tileID = pathToTileID[tilePath];
-            auto imageTile = object.cast<vsg::Data>();
-            if (imageTile)
+            // the calling thread builds the first subtile rather than waiting idle
+            auto latch = vsg::Latch::create(3);
+            for (size_t i = 1; i < 4; ++i)
             {
-                auto tile_extents = computeTileExtents(tileID.local_x, tileID.local_y, local_lod);
-                auto tile = createTile(tile_extents, imageTile);
+                buildThreads->queue->add(BuildTileOperation::create([&buildTile, i]() { buildTile(i); }, latch));
+            }
+            // the operations reference this stack frame so wait for them to complete before an exception unwinds it
+            try
+            {
+                buildTile(0);
+            }
+            catch (...)
+            {
+                latch->wait();
+                throw;
+            }
+            latch->wait();
+        }
+        else
+        {
+            for (size_t i = 0; i < 4; ++i) buildTile(i);
+        }
+
+        for (size_t i = 0; i < 4; ++i)
+        {
+            auto& tileData = tiles[i];
+            if (noDataTiles[i])
+            {
+                ++numNoDataTiles;
+            }
+            else
+            {
+                auto& tile = builtTiles[i];
+                auto& bounds = builtBounds[i];
                 if (tile)
                 {
-                    vsg::ComputeBounds computeBound;
-                    tile->accept(computeBound);
-                    auto& bb = computeBound.bounds;
-                    vsg::dsphere bound((bb.min.x + bb.max.x) * 0.5, (bb.min.y + bb.max.y) * 0.5, (bb.min.z + bb.max.z) * 0.5, vsg::length(bb.max - bb.min) * 0.5);
-
                     if (local_lod < settings->maxLevel)
                     {
                         auto plod = vsg::PagedLOD::create();
-                        plod->bound = bound;
-                        plod->children[0] = vsg::PagedLOD::Child{settings->lodTransitionScreenHeightRatio, {}}; // external child visible when it's bound occupies more than 1/4 of the height of the window
+                        plod->bound = bounds.sphere;
+                        plod->children[0] = vsg::PagedLOD::Child{settings->lodTransitionScreenHeightRatio, {}}; // external child visible when it's bound occupies more than lodTransitionScreenHeightRatio of the height of the window
                         plod->children[1] = vsg::PagedLOD::Child{0.0, tile};                                    // visible always
-                        plod->filename = vsg::make_string(tileID.local_x, " ", tileID.local_y, " ", local_lod, ".tile");
+                        plod->filename = vsg::make_string(tileData.x, " ", tileData.y, " ", local_lod, ".tile");
                         plod->options = options;
 
+                        if (scheduler) scheduler->track(tileKey(tileData.x, tileData.y, local_lod), plod);
+                        if (lodController) lodController->track(tileKey(tileData.x, tileData.y, local_lod), plod);
+
                         vsg::debug("plod->filename ", plod->filename);
 
                         group->addChild(plod);
@@ -310,7 +739,7 @@ vsg::ref_ptr<vsg::Object> TileReader::read_subtile(uint32_t x, uint32_t y, uint3
                     else
                     {
                         auto cullGroup = vsg::CullGroup::create();
-                        cullGroup->bound = bound;
+                        cullGroup->bound = bounds.sphere;
                         cullGroup->addChild(tile);
 
                         group->addChild(cullGroup);
@@ -330,7 +759,7 @@ vsg::ref_ptr<vsg::Object> TileReader::read_subtile(uint32_t x, uint32_t y, uint3
         totalTimeReadingTiles += time_to_read_tile;
     }
 
-    if (group->children.size() != 4)
+    if (group->children.size() + numNoDataTiles != 4)
     {
         vsg::warn("Could not load all 4 subtiles, loaded only ", group->children.size(), " tiles.");
 
@@ -340,92 +769,220 @@ vsg::ref_ptr<vsg::Object> TileReader::read_subtile(uint32_t x, uint32_t y, uint3
     return group;
 }
 
+vsg::ref_ptr<vsg::OperationThreads>& TileReader::defaultBuildThreads()
+{
+    static vsg::ref_ptr<vsg::OperationThreads> s_buildThreads = vsg::OperationThreads::create(std::max(1u, std::thread::hardware_concurrency()));
+    return s_buildThreads;
+}
+
 void TileReader::init(vsg::ref_ptr<const vsg::Options> options)
 {
-    if (!descriptorSetLayout)
+    if (!elevationIndex) elevationIndex = ElevationIndex::create(settings);
+    if (!meshBuilder) meshBuilder = TerrainMeshBuilder::create(s_tileGridSize);
+    if (!buildThreads) buildThreads = defaultBuildThreads();
+    if (!scheduler) scheduler = TileRequestScheduler::create();
+    if (!fetchCoalescer) fetchCoalescer = FetchCoalescer::instance();
+    if (fetchCoalescer->fileReader && !fetchCoalescer->decodeThreads) fetchCoalescer->decodeThreads = defaultBuildThreads();
+    if (!memoryMonitor)
     {
-        vsg::DescriptorSetLayoutBindings descriptorBindings{
-            {0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr} // { binding, descriptorTpe, descriptorCount, stageFlags, pImmutableSamplers}
-        };
-
-        descriptorSetLayout = vsg::DescriptorSetLayout::create(descriptorBindings);
+        memoryMonitor = TileMemoryMonitor::create();
+        memoryMonitor->fetchCoalescer = fetchCoalescer;
+        memoryMonitor->maxTileMemory = uint64_t(settings->tileMemoryBudget) * 1024 * 1024;
+        memoryMonitor->maxGDALCache = uint64_t(settings->gdalCacheBudget) * 1024 * 1024;
     }
-
-    if (!pipelineLayout)
+    if (!lodController && settings->targetFrameTime > 0.0)
     {
-        vsg::PushConstantRanges pushConstantRanges{
-            {VK_SHADER_STAGE_VERTEX_BIT, 0, 128} // projection view, and model matrices, actual push constant calls autoaatically provided by the VSG's DispatchTraversal
-        };
+        lodController = LODController::create(settings->lodTransitionScreenHeightRatio, settings->maxLevel);
+        lodController->targetFrameTime = settings->targetFrameTime;
+        lodController->memoryMonitor = memoryMonitor;
+    }
+
+    auto openArchive = [&](const vsg::Path& layer, vsg::ref_ptr<TileArchive>& archive) {
+        if (archive || vsg::lowerCaseFileExtension(layer) != TileArchive::fileExtension) return;
 
-        pipelineLayout = vsg::PipelineLayout::create(vsg::DescriptorSetLayouts{descriptorSetLayout}, pushConstantRanges);
+        auto candidate = TileArchive::create();
+        auto filename = vsg::findFile(layer, options);
+        if (!filename.empty() && candidate->open(filename))
+        {
+            archive = candidate;
+        }
+        else
+        {
+            vsg::warn("TileReader::init() unable to open tile archive ", layer);
+        }
+    };
+
+    openArchive(settings->imageLayer, imageArchive);
+    openArchive(settings->terrainLayer, terrainArchive);
+
+    // an imageLayer without {x}, {y} or {z} fields that isn't an archive is read as a MosaicIndex of source datasets
+    auto& imageLayer = settings->imageLayer;
+    if (!imageArchive && !imageMosaic && !imageLayer.empty() && imageLayer.find('{') == vsg::Path::npos && vsg::lowerCaseFileExtension(imageLayer) != TileArchive::fileExtension)
+    {
+        initGDAL();
+        imageMosaic = vsg::read_cast<MosaicIndex>(imageLayer, options);
+        if (!imageMosaic) vsg::warn("TileReader::init() unable to read MosaicIndex ", imageLayer);
     }
+    if (!datasetPool) datasetPool = DatasetPool::instance();
 
-    if (!sampler)
+    overlayArchives.resize(settings->overlayLayers.size());
+    for (size_t i = 0; i < settings->overlayLayers.size(); ++i)
     {
-        sampler = vsg::Sampler::create();
-        sampler->maxLod = settings->mipmapLevelsHint;
-        sampler->addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-        sampler->addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-        sampler->addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-        sampler->anisotropyEnable = VK_TRUE;
-        sampler->maxAnisotropy = 16.0f;
+        if (settings->overlayLayers[i]) openArchive(settings->overlayLayers[i]->path, overlayArchives[i]);
     }
 
-    if (!graphicsPipeline)
+    // the pipeline and sampler are shared with the other TileReader using the same rendering settings
+    if (!renderContext) renderContext = TileRenderContext::get(TileRenderContext::createKey(settings->mipmapLevelsHint, settings->compactVertices, options), options);
+
+    if (!descriptorSetLayout) descriptorSetLayout = renderContext->descriptorSetLayout;
+    if (!pipelineLayout) pipelineLayout = renderContext->pipelineLayout;
+    if (!sampler) sampler = renderContext->sampler;
+    if (!graphicsPipeline) graphicsPipeline = renderContext->graphicsPipeline;
+}
+
+vsg::ref_ptr<vsg::StateGroup> TileReader::createRoot() const
+{
+    auto root = vsg::StateGroup::create();
+
+    // reuse the context's BindGraphicsPipeline so the pipeline isn't rebound between databases sharing the context
+    if (renderContext && graphicsPipeline == renderContext->graphicsPipeline)
+        root->add(renderContext->bindGraphicsPipeline);
+    else
+        root->add(vsg::BindGraphicsPipeline::create(graphicsPipeline));
+
+    return root;
+}
+
+vsg::ref_ptr<vsg::floatArray2D> TileReader::createHeights(const vsg::dbox& tile_extents, vsg::ref_ptr<vsg::Data> terrainData, uint32_t numColumns, uint32_t numRows) const
+{
+    if (settings->terrainLayer.empty()) return {};
+
+    auto heights = vsg::floatArray2D::create(numColumns, numRows);
+
+    uint32_t width = terrainData ? terrainData->width() : 0;
+    uint32_t height = terrainData ? terrainData->height() : 0;
+    if (width >= 2 && height >= 2)
     {
-        auto vertexShader = vsg::read_cast<vsg::ShaderStage>("shaders/simple_tile.vert", options);
-        if (!vertexShader) vertexShader = simple_tile_vert(); // fallback to shaders/simple_tile_vert.cppp
+        auto& layout = terrainData->getLayout();
+        size_t stride = layout.stride > 0 ? layout.stride : terrainData->valueSize();
+        const uint8_t* ptr = static_cast<const uint8_t*>(terrainData->dataPointer());
 
-        auto fragmentShader = vsg::read_cast<vsg::ShaderStage>("shaders/simple_tile.frag", options);
-        if (!fragmentShader) fragmentShader = simple_tile_frag(); // fallback to shaders/simple_tile_frag.cppp
+        // half float and quantized terrain, as created by convertToHalfFloat(..) and quantizeToUNorm16(..), is decoded as value = offset + scale * sample
+        double offset = 0.0, scale = 1.0;
+        terrainData->getValue("offset", offset);
+        bool normalized = terrainData->getValue("scale", scale);
 
-        if (!vertexShader || !fragmentShader)
-        {
-            vsg::error("Could not create shaders.");
-        }
+        double noDataValue = 0.0;
+        bool hasNoData = terrainData->getValue("NoDataValue", noDataValue);
 
-        vsg::VertexInputState::Bindings vertexBindingsDescriptions{
-            VkVertexInputBindingDescription{0, sizeof(vsg::vec3), VK_VERTEX_INPUT_RATE_VERTEX}, // vertex data
-            VkVertexInputBindingDescription{1, sizeof(vsg::vec3), VK_VERTEX_INPUT_RATE_VERTEX}, // colour data
-            VkVertexInputBindingDescription{2, sizeof(vsg::vec2), VK_VERTEX_INPUT_RATE_VERTEX}  // tex coord data
-        };
+        // quantized terrain reserves a raw sample for NoData, as recorded by quantizeToUNorm16(..), which has to be tested before decoding
+        double noDataSample = 0.0;
+        bool hasNoDataSample = terrainData->getValue("NoDataSample", noDataSample);
+
+        bool topLeft = layout.origin == vsg::TOP_LEFT;
+
+        // terrain tiles of 2^n+1 samples, such as 257x257, have samples on the tile edges, otherwise samples are at pixel centres
+        bool edgeAligned = (width & 1) == 1 && (height & 1) == 1;
+
+        // readSample returns the raw sample, normalizer maps it to the value sampled by the GPU
+        auto sampleGrid = [&](auto readSample, double normalizer) {
+            auto decode = [&](uint32_t i, uint32_t j) {
+                double sample = readSample(ptr + (size_t(i) + size_t(j) * width) * stride);
+                if (hasNoDataSample && sample == noDataSample) return std::numeric_limits<double>::quiet_NaN();
+
+                double value = offset + scale * normalizer * sample;
+                return (std::isnan(value) || (hasNoData && value == noDataValue)) ? std::numeric_limits<double>::quiet_NaN() : value;
+            };
+
+            for (uint32_t r = 0; r < numRows; ++r)
+            {
+                double v = double(r) / double(numRows - 1);
+                if (topLeft) v = 1.0 - v;
+                double py = std::clamp(edgeAligned ? v * double(height - 1) : v * double(height) - 0.5, 0.0, double(height - 1));
+
+                for (uint32_t c = 0; c < numColumns; ++c)
+                {
+                    double u = double(c) / double(numColumns - 1);
+                    double px = std::clamp(edgeAligned ? u * double(width - 1) : u * double(width) - 0.5, 0.0, double(width - 1));
+
+                    uint32_t i = std::min(static_cast<uint32_t>(px), width - 2);
+                    uint32_t j = std::min(static_cast<uint32_t>(py), height - 2);
+                    double tx = px - double(i);
+                    double ty = py - double(j);
+
+                    double value = (decode(i, j) * (1.0 - tx) + decode(i + 1, j) * tx) * (1.0 - ty) + (decode(i, j + 1) * (1.0 - tx) + decode(i + 1, j + 1) * tx) * ty;
 
-        vsg::VertexInputState::Attributes vertexAttributeDescriptions{
-            VkVertexInputAttributeDescription{0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0}, // vertex data
-            VkVertexInputAttributeDescription{1, 1, VK_FORMAT_R32G32B32_SFLOAT, 0}, // colour data
-            VkVertexInputAttributeDescription{2, 2, VK_FORMAT_R32G32_SFLOAT, 0},    // tex coord data
+                    // NoData samples mustn't be blended so fall back to the nearest sample, and then to the ellipsoid surface
+                    if (std::isnan(value)) value = decode(static_cast<uint32_t>(px + 0.5), static_cast<uint32_t>(py + 0.5));
+                    heights->at(c, r) = std::isnan(value) ? 0.0f : static_cast<float>(value);
+                }
+            }
+            return true;
         };
 
-        vsg::GraphicsPipelineStates pipelineStates{
-            vsg::VertexInputState::create(vertexBindingsDescriptions, vertexAttributeDescriptions),
-            vsg::InputAssemblyState::create(),
-            vsg::RasterizationState::create(),
-            vsg::MultisampleState::create(),
-            vsg::ColorBlendState::create(),
-            vsg::DepthStencilState::create()};
+        bool sampled = false;
+        if (layout.format == VK_FORMAT_R16_SFLOAT)
+        {
+            sampled = sampleGrid([](const uint8_t* p) {
+                uint16_t half;
+                std::memcpy(&half, p, sizeof(half));
+                return double(halfToFloat(half));
+            }, 1.0);
+        }
+        else
+        {
+            sampled = dispatchImageFormat(layout.format, [&](auto rasterType) -> bool {
+                using T = typename decltype(rasterType)::component_type;
+
+                // quantized data is sampled by the GPU as normalized values
+                double normalizer = (normalized && std::is_same_v<T, uint16_t>) ? 1.0 / 65535.0 : 1.0;
+                return sampleGrid([](const uint8_t* p) {
+                    T value;
+                    std::memcpy(&value, p, sizeof(T));
+                    return double(value);
+                }, normalizer);
+            });
+        }
+
+        if (sampled) return heights;
 
-        graphicsPipeline = vsg::GraphicsPipeline::create(pipelineLayout, vsg::ShaderStages{vertexShader, fragmentShader}, pipelineStates);
+        vsg::warn("TileReader::createHeights() unsupported terrain format ", layout.format);
     }
-}
 
-vsg::ref_ptr<vsg::StateGroup> TileReader::createRoot() const
-{
-    auto root = vsg::StateGroup::create();
-    root->add(vsg::BindGraphicsPipeline::create(graphicsPipeline));
+    // no terrain data for this tile so fall back to the heights of the resident parent tile, or the ellipsoid surface if there is none
+    std::vector<vsg::dvec2> latitudeLongitudes;
+    latitudeLongitudes.reserve(size_t(numColumns) * numRows);
+    for (uint32_t r = 0; r < numRows; ++r)
+    {
+        for (uint32_t c = 0; c < numColumns; ++c)
+        {
+            vsg::dvec3 location(tile_extents.min.x + (tile_extents.max.x - tile_extents.min.x) * double(c) / double(numColumns - 1),
+                                tile_extents.min.y + (tile_extents.max.y - tile_extents.min.y) * double(r) / double(numRows - 1), 0.0);
+            auto latitudeLongitudeAltitude = computeLatitudeLongitudeAltitude(location);
+            latitudeLongitudes.emplace_back(latitudeLongitudeAltitude.x, latitudeLongitudeAltitude.y);
+        }
+    }
 
-    return root;
+    std::vector<ElevationIndex::Result> results(latitudeLongitudes.size());
+    elevationIndex->query(latitudeLongitudes.size(), latitudeLongitudes.data(), results.data());
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        heights->at(i % numColumns, i / numColumns) = static_cast<float>(results[i].height);
+    }
+
+    return heights;
 }
 
-vsg::ref_ptr<vsg::Node> TileReader::createTile(const vsg::dbox& tile_extents, vsg::ref_ptr<vsg::Data> sourceData) const
+vsg::ref_ptr<vsg::Node> TileReader::createTile(const vsg::dbox& tile_extents, vsg::ref_ptr<vsg::Data> sourceData, vsg::ref_ptr<vsg::Data> terrainData, TileBounds& bounds) const
 {
 #if 1
-    return createECEFTile(tile_extents, sourceData);
+    return createECEFTile(tile_extents, sourceData, createHeights(tile_extents, terrainData, s_tileGridSize, s_tileGridSize), bounds);
 #else
-    return createTextureQuad(tile_extents, sourceData);
+    return createTextureQuad(tile_extents, sourceData, bounds);
 #endif
 }
 
-vsg::ref_ptr<vsg::Node> TileReader::createECEFTile(const vsg::dbox& tile_extents, vsg::ref_ptr<vsg::Data> textureData) const
+vsg::ref_ptr<vsg::Node> TileReader::createECEFTile(const vsg::dbox& tile_extents, vsg::ref_ptr<vsg::Data> textureData, vsg::ref_ptr<vsg::floatArray2D> heights, TileBounds& bounds) const
 {
     vsg::dvec3 center = computeLatitudeLongitudeAltitude((tile_extents.min + tile_extents.max) * 0.5);
 
@@ -448,10 +1005,16 @@ vsg::ref_ptr<vsg::Node> TileReader::createECEFTile(const vsg::dbox& tile_extents
     // add transform to root of the scene graph
     scenegraph->addChild(transform);
 
-    uint32_t numRows = 32;
-    uint32_t numCols = 32;
-    uint32_t numVertices = numRows * numCols;
-    uint32_t numTriangles = (numRows - 1) * (numCols - 1) * 2;
+    // the mesh is simplified from a full resolution grid of the size the meshBuilder supports
+    uint32_t numRows = meshBuilder->gridSize;
+    uint32_t numCols = meshBuilder->gridSize;
+    uint32_t numGridVertices = numRows * numCols;
+
+    if (heights && (heights->width() != numCols || heights->height() != numRows))
+    {
+        vsg::warn("TileReader::createECEFTile() heights of ", heights->width(), "x", heights->height(), " don't match the mesh grid of ", numCols, "x", numRows);
+        heights = {};
+    }
 
     double longitudeOrigin = tile_extents.min.x;
     double longitudeScale = (tile_extents.max.x - tile_extents.min.x) / double(numCols - 1);
@@ -469,58 +1032,210 @@ vsg::ref_ptr<vsg::Node> TileReader::createECEFTile(const vsg::dbox& tile_extents
 
     vsg::vec3 color(1.0f, 1.0f, 1.0f);
 
-    // set up vertex coords
-    auto vertices = vsg::vec3Array::create(numVertices);
-    auto colors = vsg::vec3Array::create(numVertices);
-    auto texcoords = vsg::vec2Array::create(numVertices);
+    // approximate the reprojection of the vertices with a control grid, falling back to exact per vertex reprojection if it can't be created.
+    // The grid is refined no further than the vertex grid, at which resolution it's control points are the exact reprojection of each vertex so are used directly.
+    vsg::ref_ptr<ReprojectionGrid> reprojectionGrid;
+    if (auto reprojection = settings->getReprojection()) reprojectionGrid = reprojection->createGrid(tile_extents, settings->reprojectionErrorThreshold, numCols - 1);
+    bool exactGrid = reprojectionGrid && reprojectionGrid->resolution == numCols - 1 && numRows == numCols;
+
+    // set up the full resolution grid of vertex coords
+    std::vector<vsg::dvec3> gridLatitudeLongitudeAltitudes(numGridVertices);
+    std::vector<vsg::vec3> gridVertices(numGridVertices);
     for (uint32_t r = 0; r < numRows; ++r)
     {
         for (uint32_t c = 0; c < numCols; ++c)
         {
             vsg::dvec3 location(longitudeOrigin + double(c) * longitudeScale, latitudeOrigin + double(r) * latitudeScale, 0.0);
-            vsg::dvec3 latitudeLongitudeAltitude = computeLatitudeLongitudeAltitude(location);
+            vsg::dvec3 latitudeLongitudeAltitude;
+            if (exactGrid)
+            {
+                auto& longitudeLatitudeAltitude = reprojectionGrid->points[c + r * numCols];
+                latitudeLongitudeAltitude = vsg::dvec3(longitudeLatitudeAltitude.y, longitudeLatitudeAltitude.x, longitudeLatitudeAltitude.z);
+            }
+            else if (reprojectionGrid)
+            {
+                auto longitudeLatitudeAltitude = reprojectionGrid->transform(location);
+                latitudeLongitudeAltitude = vsg::dvec3(longitudeLatitudeAltitude.y, longitudeLatitudeAltitude.x, longitudeLatitudeAltitude.z);
+            }
+            else
+            {
+                latitudeLongitudeAltitude = computeLatitudeLongitudeAltitude(location);
+            }
 
-            auto ecef = settings->ellipsoidModel->convertLatLongAltitudeToECEF(latitudeLongitudeAltitude);
-            vsg::vec3 vertex(worldToLocal * ecef);
-            vsg::vec2 texcoord(float(c) * sCoordScale, tCoordOrigin + float(r) * tCoordScale);
+            if (heights) latitudeLongitudeAltitude.z = heights->at(c, r);
 
             uint32_t vi = c + r * numCols;
-            vertices->set(vi, vertex);
-            colors->set(vi, color);
-            texcoords->set(vi, texcoord);
+            gridLatitudeLongitudeAltitudes[vi] = latitudeLongitudeAltitude;
+            gridVertices[vi] = vsg::vec3(worldToLocal * settings->ellipsoidModel->convertLatLongAltitudeToECEF(latitudeLongitudeAltitude));
+        }
+    }
+
+    // simplify the grid to an error bounded mesh, with the error specified relative to the grid spacing so the error on screen is similar at all levels
+    double gridSpacing = std::max(vsg::length(gridVertices[numCols - 1] - gridVertices[0]), vsg::length(gridVertices[(numRows - 1) * numCols] - gridVertices[0])) / double(numCols - 1);
+    float maxError = settings->terrainMeshError >= 0.0 ? static_cast<float>(settings->terrainMeshError * gridSpacing) : -1.0f;
+
+    std::vector<uint32_t> gridIndices;
+    std::vector<uint16_t> meshIndices;
+    float geometricError = meshBuilder->createMesh(meshBuilder->computeErrors(gridVertices.data()), maxError, gridIndices, meshIndices);
+
+    // adjacent tiles are simplified independently, so hang skirts below the tile edges to hide the cracks between them
+    float skirtDepth = 4.0f * maxError;
+    std::vector<std::pair<uint16_t, uint16_t>> skirtEdges;
+    if (skirtDepth > 0.0f)
+    {
+        uint32_t maxIndex = numCols - 1;
+        auto onSameEdge = [&](uint32_t lhs, uint32_t rhs) {
+            uint32_t lc = lhs % numCols, lr = lhs / numCols, rc = rhs % numCols, rr = rhs / numCols;
+            return (lc == rc && (lc == 0 || lc == maxIndex)) || (lr == rr && (lr == 0 || lr == maxIndex));
+        };
+
+        for (size_t i = 0; i < meshIndices.size(); i += 3)
+        {
+            for (size_t e = 0; e < 3; ++e)
+            {
+                uint16_t a = meshIndices[i + e];
+                uint16_t b = meshIndices[i + (e + 1) % 3];
+                if (onSameEdge(gridIndices[a], gridIndices[b])) skirtEdges.emplace_back(a, b);
+            }
+        }
+    }
+
+    uint32_t numMeshVertices = static_cast<uint32_t>(gridIndices.size());
+    uint32_t numVertices = numMeshVertices + static_cast<uint32_t>(skirtEdges.size()) * 2;
+
+    // local bounding box of the tile, accumulated as the vertices are generated
+    vsg::box localBounds;
+
+    auto vertices = vsg::vec3Array::create(numVertices);
+    auto texcoords = vsg::vec2Array::create(numVertices);
+    auto indices = vsg::ushortArray::create(meshIndices.size() + skirtEdges.size() * 6);
+
+    for (uint32_t i = 0; i < numMeshVertices; ++i)
+    {
+        uint32_t gridIndex = gridIndices[i];
+        uint32_t c = gridIndex % numCols;
+        uint32_t r = gridIndex / numCols;
+
+        vertices->set(i, gridVertices[gridIndex]);
+        localBounds.add(gridVertices[gridIndex]);
+        texcoords->set(i, vsg::vec2(float(c) * sCoordScale, tCoordOrigin + float(r) * tCoordScale));
+    }
+
+    std::copy(meshIndices.begin(), meshIndices.end(), indices->begin());
+
+    // each skirt edge a, b of a counter clockwise triangle gets a quad a, a', b and b, a', b' facing out of the tile
+    uint32_t vi = numMeshVertices;
+    auto itr = indices->begin() + meshIndices.size();
+    for (auto& [a, b] : skirtEdges)
+    {
+        uint16_t base = static_cast<uint16_t>(vi);
+        for (auto index : {a, b})
+        {
+            auto latitudeLongitudeAltitude = gridLatitudeLongitudeAltitudes[gridIndices[index]];
+            latitudeLongitudeAltitude.z -= skirtDepth;
+
+            vsg::vec3 skirtVertex(worldToLocal * settings->ellipsoidModel->convertLatLongAltitudeToECEF(latitudeLongitudeAltitude));
+            vertices->set(vi, skirtVertex);
+            localBounds.add(skirtVertex);
+            texcoords->set(vi, texcoords->at(index));
+            ++vi;
         }
+
+        (*itr++) = a;
+        (*itr++) = base;
+        (*itr++) = b;
+        (*itr++) = b;
+        (*itr++) = base;
+        (*itr++) = base + 1;
     }
 
-    // set up indices
-    auto indices = vsg::ushortArray::create(numTriangles * 3);
-    auto itr = indices->begin();
-    for (uint32_t r = 0; r < numRows - 1; ++r)
+    vsg::DataList arrays;
+    if (settings->compactVertices)
     {
-        for (uint32_t c = 0; c < numCols - 1; ++c)
+        // quantize the positions to the tile's local bounding box, the transform dequantizes them by mapping the unit box onto the bounding box
+        vsg::vec3 size = localBounds.max - localBounds.min;
+        for (size_t i = 0; i < 3; ++i)
         {
-            uint32_t vi = c + r * numCols;
-            (*itr++) = vi;
-            (*itr++) = vi + 1;
-            (*itr++) = vi + numCols;
-            (*itr++) = vi + numCols;
-            (*itr++) = vi + 1;
-            (*itr++) = vi + numCols + 1;
+            if (size[i] <= 0.0f) size[i] = 1.0f;
         }
+        auto positions = vsg::usvec4Array::create(numVertices); // VK_FORMAT_R16G16B16A16_UNORM
+        auto quantizedTexcoords = vsg::usvec2Array::create(numVertices); // VK_FORMAT_R16G16_UNORM
+
+        auto quantize = [](float value) { return static_cast<uint16_t>(std::min(65535.0f, std::max(0.0f, value)) + 0.5f); };
+        for (uint32_t i = 0; i < numVertices; ++i)
+        {
+            vsg::vec3 p = vertices->at(i) - localBounds.min;
+            positions->set(i, vsg::usvec4(quantize(p.x * 65535.0f / size.x), quantize(p.y * 65535.0f / size.y), quantize(p.z * 65535.0f / size.z), 65535));
+
+            vsg::vec2 tc = texcoords->at(i) * 65535.0f;
+            quantizedTexcoords->set(i, vsg::usvec2(quantize(tc.x), quantize(tc.y)));
+        }
+
+        transform->matrix = localToWorld * vsg::translate(vsg::dvec3(localBounds.min)) * vsg::scale(vsg::dvec3(size));
+
+        // the color is constant across the tile so is bound once, per instance
+        arrays = vsg::DataList{positions, vsg::vec3Array::create({color}), quantizedTexcoords};
+    }
+    else
+    {
+        auto colors = vsg::vec3Array::create(numVertices);
+        for (auto& c : *colors) c = color;
+
+        arrays = vsg::DataList{vertices, colors, texcoords};
     }
 
     // setup geometry
     auto drawCommands = vsg::Commands::create();
-    drawCommands->addChild(vsg::BindVertexBuffers::create(0, vsg::DataList{vertices, colors, texcoords}));
+    drawCommands->addChild(vsg::BindVertexBuffers::create(0, arrays));
     drawCommands->addChild(vsg::BindIndexBuffer::create(indices));
+
+    // the heights attached below are not uploaded so remain available to the ElevationIndex and to child tiles
+    if (settings->releaseDataAfterTransfer)
+    {
+        releaseAfterTransfer(arrays);
+        releaseAfterTransfer(vsg::DataList{textureData, indices});
+    }
     drawCommands->addChild(vsg::DrawIndexed::create(indices->size(), 1, 0, 0, 0));
 
     // add drawCommands to transform
     transform->addChild(drawCommands);
 
+    // attach the heights so they can be registered with the ElevationIndex
+    if (heights) scenegraph->setObject("Heights", heights);
+
+    // geometric error of the simplified mesh in meters, for use in LOD decisions
+    scenegraph->setValue("geometricError", double(geometricError));
+
+    // the local frame is aligned with the tile's surface so the local bounding box is a tight oriented box, and the sphere centered on it is tighter than one around the ECEF aligned box
+    vsg::dvec3 localCenter = (vsg::dvec3(localBounds.min) + vsg::dvec3(localBounds.max)) * 0.5;
+    double radius2 = 0.0;
+    for (auto& v : *vertices) radius2 = std::max(radius2, vsg::length2(vsg::dvec3(v) - localCenter));
+
+    bounds.sphere.center = localToWorld * localCenter;
+    bounds.sphere.radius = std::sqrt(radius2);
+    bounds.orientedBox = localToWorld * vsg::translate(localCenter) * vsg::scale((vsg::dvec3(localBounds.max) - vsg::dvec3(localBounds.min)) * 0.5);
+
+    scenegraph->setValue("orientedBound", bounds.orientedBox);
+
+    if (memoryMonitor)
+    {
+        TileMemoryMonitor::Usage usage;
+        usage.bytes[TileMemoryMonitor::IMAGE_DATA] = textureData->dataSize();
+        for (auto& array : arrays) usage.bytes[TileMemoryMonitor::VERTEX_DATA] += array->dataSize();
+        usage.bytes[TileMemoryMonitor::INDEX_DATA] = indices->dataSize();
+        if (heights) usage.bytes[TileMemoryMonitor::HEIGHTS] = heights->dataSize();
+
+        // the texture, vertices and indices are released from system memory once transferred, the heights are kept for the ElevationIndex
+        if (settings->releaseDataAfterTransfer) usage.gpuOnlyBytes = usage.bytes[TileMemoryMonitor::IMAGE_DATA] + usage.bytes[TileMemoryMonitor::VERTEX_DATA] + usage.bytes[TileMemoryMonitor::INDEX_DATA];
+        usage.numDescriptorSets = 1;
+        usage.numTiles = 1;
+        memoryMonitor->track(scenegraph, usage);
+    }
+
     return scenegraph;
 }
 
-vsg::ref_ptr<vsg::Node> TileReader::createTextureQuad(const vsg::dbox& tile_extents, vsg::ref_ptr<vsg::Data> textureData) const
+vsg::ref_ptr<vsg::Node> TileReader::createTextureQuad(const vsg::dbox& tile_extents, vsg::ref_ptr<vsg::Data> textureData, TileBounds& bounds) const
 {
     if (!textureData) return {};
 
@@ -582,10 +1297,19 @@ vsg::ref_ptr<vsg::Node> TileReader::createTextureQuad(const vsg::dbox& tile_exte
     auto drawCommands = vsg::Commands::create();
     drawCommands->addChild(vsg::BindVertexBuffers::create(0, vsg::DataList{vertices, colors, texcoords}));
     drawCommands->addChild(vsg::BindIndexBuffer::create(indices));
+
+    if (settings->releaseDataAfterTransfer) releaseAfterTransfer(vsg::DataList{textureData, vertices, colors, texcoords, indices});
     drawCommands->addChild(vsg::DrawIndexed::create(6, 1, 0, 0, 0));
 
     // add drawCommands to transform
     transform->addChild(drawCommands);
 
+    // the quad is flat so it's bounds follow directly from it's corners
+    vsg::dvec3 center((min_x + max_x) * 0.5, 0.0, (min_y + max_y) * 0.5);
+    vsg::dvec3 halfSize((max_x - min_x) * 0.5, 0.0, (max_y - min_y) * 0.5);
+    bounds.sphere.center = center;
+    bounds.sphere.radius = vsg::length(halfSize);
+    bounds.orientedBox = vsg::translate(center) * vsg::scale(halfSize);
+
     return scenegraph;
 }
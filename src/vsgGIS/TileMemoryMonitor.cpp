@@ -0,0 +1,128 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsgGIS/TileMemoryMonitor.h>
+
+#include <gdal_priv.h>
+
+#include <algorithm>
+
+using namespace vsgGIS;
+
+namespace
+{
+    // fraction of a budget that usage must fall below before restrictions are lifted, so enforcement doesn't oscillate
+    constexpr double s_restoreThreshold = 0.8;
+
+    // minimum number of high resolution PagedLOD the pager is restricted to
+    constexpr uint32_t s_minPagerTarget = 64;
+} // namespace
+
+// attached to a tile, releasing it's accounting when the tile is deleted
+struct TileMemoryMonitor::Record : public vsg::Inherit<vsg::Object, TileMemoryMonitor::Record>
+{
+    Record(vsg::ref_ptr<TileMemoryMonitor> in_monitor, const Usage& in_usage) :
+        monitor(in_monitor),
+        usage(in_usage) {}
+
+    vsg::ref_ptr<TileMemoryMonitor> monitor;
+    Usage usage;
+
+protected:
+    ~Record()
+    {
+        monitor->_release(usage);
+    }
+};
+
+TileMemoryMonitor::TileMemoryMonitor()
+{
+    for (auto& bytes : _bytes) bytes = 0;
+}
+
+TileMemoryMonitor::~TileMemoryMonitor()
+{
+}
+
+void TileMemoryMonitor::track(vsg::Object* tile, const Usage& usage)
+{
+    if (!tile) return;
+
+    for (int i = 0; i < NUM_CATEGORIES; ++i) _bytes[i] += usage.bytes[i];
+    _gpuOnlyBytes += usage.gpuOnlyBytes;
+    _numDescriptorSets += usage.numDescriptorSets;
+    _numTiles += usage.numTiles;
+
+    tile->setObject("MemoryRecord", Record::create(vsg::ref_ptr<TileMemoryMonitor>(this), usage));
+}
+
+void TileMemoryMonitor::_release(const Usage& usage)
+{
+    for (int i = 0; i < NUM_CATEGORIES; ++i) _bytes[i] -= usage.bytes[i];
+    _gpuOnlyBytes -= usage.gpuOnlyBytes;
+    _numDescriptorSets -= usage.numDescriptorSets;
+    _numTiles -= usage.numTiles;
+}
+
+TileMemoryMonitor::Report TileMemoryMonitor::getReport() const
+{
+    Report report;
+    for (int i = 0; i < NUM_CATEGORIES; ++i) report.tiles.bytes[i] = _bytes[i];
+    report.tiles.gpuOnlyBytes = _gpuOnlyBytes;
+    report.tiles.numDescriptorSets = _numDescriptorSets;
+    report.tiles.numTiles = _numTiles;
+    if (fetchCoalescer) report.fetchCacheSize = fetchCoalescer->getMetrics().cacheSize;
+    report.gdalCacheSize = static_cast<uint64_t>(GDALGetCacheUsed64());
+    return report;
+}
+
+void TileMemoryMonitor::enforce(vsg::DatabasePager& pager)
+{
+    auto report = getReport();
+
+    if (maxTileMemory > 0)
+    {
+        uint64_t tileMemory = report.tiles.systemMemory();
+        if (tileMemory > maxTileMemory)
+        {
+            if (_pagerTarget == 0) _pagerTarget = pager.targetMaxNumPagedLODWithHighResSubgraphs;
+
+            // each high resolution PagedLOD holds four tiles, so scale the number resident to fit within the budget
+            double scale = double(maxTileMemory) / double(tileMemory);
+            uint32_t resident = static_cast<uint32_t>(report.tiles.numTiles / 4);
+            uint32_t target = std::max(s_minPagerTarget, static_cast<uint32_t>(double(resident) * scale));
+            pager.targetMaxNumPagedLODWithHighResSubgraphs = std::min(pager.targetMaxNumPagedLODWithHighResSubgraphs, target);
+        }
+        else if (_pagerTarget > 0 && double(tileMemory) < double(maxTileMemory) * s_restoreThreshold)
+        {
+            pager.targetMaxNumPagedLODWithHighResSubgraphs = _pagerTarget;
+            _pagerTarget = 0;
+        }
+    }
+
+    if (maxGDALCache > 0 && static_cast<uint64_t>(GDALGetCacheMax64()) > maxGDALCache)
+    {
+        // GDAL flushes the least recently used blocks to fit within the new maximum
+        GDALSetCacheMax64(static_cast<GIntBig>(maxGDALCache));
+    }
+}
@@ -0,0 +1,203 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsgGIS/TileDatabase.h>
+#include <vsgGIS/TilePrefetcher.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+using namespace vsgGIS;
+
+namespace
+{
+    // maximum number of tiles remembered as queued before the record is reset, so tiles evicted from the cache can be prefetched again
+    constexpr size_t s_maxQueued = 16384;
+
+    // period the prefetch thread sleeps while deferring to on demand requests or the bandwidth cap
+    constexpr std::chrono::milliseconds s_deferPeriod(10);
+} // namespace
+
+TilePrefetcher::TilePrefetcher(vsg::ref_ptr<TileReader> in_reader, vsg::ref_ptr<const vsg::Options> in_options) :
+    _reader(in_reader),
+    _options(in_options)
+{
+    _thread = std::thread([this]() { _run(); });
+}
+
+TilePrefetcher::~TilePrefetcher()
+{
+    {
+        std::scoped_lock<std::mutex> lock(_mutex);
+        _done = true;
+    }
+    _condition.notify_all();
+
+    if (_thread.joinable()) _thread.join();
+}
+
+void TilePrefetcher::update(const vsg::dvec3& eye, double time)
+{
+    if (_hasPrevious && time > _previousTime)
+    {
+        // smooth the velocity so that frame to frame jitter doesn't throw the prediction around
+        vsg::dvec3 velocity = (eye - _previousEye) / (time - _previousTime);
+        _velocity = _velocity * 0.5 + velocity * 0.5;
+    }
+
+    _previousEye = eye;
+    _previousTime = time;
+    _hasPrevious = true;
+
+    // replace the tiles still waiting from the previous prediction so the queue follows the latest motion
+    {
+        std::scoped_lock<std::mutex> lock(_mutex);
+        for (auto key : _queue) _queued.erase(key);
+        _queue.clear();
+    }
+
+    // select tiles at points along the predicted path, nearest first so the tiles needed soonest are loaded first
+    for (uint32_t i = 1; i <= numPredictions; ++i)
+    {
+        double t = lookAheadTime * double(i) / double(numPredictions);
+        _queueTiles(eye + _velocity * t);
+    }
+}
+
+void TilePrefetcher::_queueTiles(const vsg::dvec3& eye)
+{
+    auto& settings = _reader->settings;
+    auto& ellipsoidModel = settings->ellipsoidModel;
+
+    vsg::dvec3 latitudeLongitudeAltitude = ellipsoidModel->convertECEFToLatLongAltitude(eye);
+    vsg::dvec3 location = settings->computeTileLocation(vsg::dvec3(latitudeLongitudeAltitude.x, latitudeLongitudeAltitude.y, 0.0));
+
+    double tanHalfFieldOfView = std::tan(vsg::radians(fieldOfViewY) * 0.5);
+
+    std::vector<uint64_t> keys;
+
+    // descend the levels for as long as the tile under the eye would be subdivided, queuing the tile and it's neighbours at each level that would be requested
+    for (uint32_t level = 0; level < settings->maxLevel; ++level)
+    {
+        uint32_t x, y;
+        if (!settings->computeTileCoordinates(location, level, x, y)) break;
+
+        auto extents = settings->computeTileExtents(x, y, level);
+        vsg::dvec3 corner_min = ellipsoidModel->convertLatLongAltitudeToECEF(settings->computeLatitudeLongitudeAltitude(extents.min));
+        vsg::dvec3 corner_max = ellipsoidModel->convertLatLongAltitudeToECEF(settings->computeLatitudeLongitudeAltitude(extents.max));
+        vsg::dvec3 center = ellipsoidModel->convertLatLongAltitudeToECEF(settings->computeLatitudeLongitudeAltitude((extents.min + extents.max) * 0.5));
+
+        double radius = vsg::length(corner_max - corner_min) * 0.5;
+        double distance = std::max(vsg::length(eye - center), radius * 0.01);
+        if (radius / (distance * tanHalfFieldOfView) <= settings->lodTransitionScreenHeightRatio) break;
+
+        // the subtiles of the tile and it's neighbours will be requested together
+        uint32_t childLevel = level + 1;
+        uint32_t numColumns = settings->noX << childLevel;
+        uint32_t numRows = settings->noY << childLevel;
+        uint32_t cx = x * 2, cy = y * 2;
+        for (uint32_t ty = (cy >= 2 ? cy - 2 : 0); ty < std::min(numRows, cy + 4); ++ty)
+        {
+            for (uint32_t tx = (cx >= 2 ? cx - 2 : 0); tx < std::min(numColumns, cx + 4); ++tx)
+            {
+                keys.push_back(tileKey(tx, ty, childLevel));
+            }
+        }
+    }
+
+    if (keys.empty()) return;
+
+    {
+        std::scoped_lock<std::mutex> lock(_mutex);
+
+        if (_queued.size() > s_maxQueued) _queued.clear();
+
+        for (auto key : keys)
+        {
+            if (_queued.insert(key).second)
+            {
+                _queue.push_back(key);
+                ++_metrics.numQueued;
+            }
+        }
+    }
+
+    _condition.notify_one();
+}
+
+void TilePrefetcher::_run()
+{
+    using clock = std::chrono::steady_clock;
+
+    // token bucket allowing up to one second's worth of bandwidth in a burst
+    double budget = maxBandwidth;
+    auto lastRefill = clock::now();
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (!_done)
+    {
+        if (_queue.empty())
+        {
+            _condition.wait(lock);
+            continue;
+        }
+
+        auto now = clock::now();
+        budget = std::min(maxBandwidth, budget + maxBandwidth * std::chrono::duration<double>(now - lastRefill).count());
+        lastRefill = now;
+
+        bool onDemandWaiting = _reader->scheduler && _reader->scheduler->getMetrics().numWaiting > 0;
+        if (budget <= 0.0 || onDemandWaiting)
+        {
+            ++_metrics.numDeferred;
+            _condition.wait_for(lock, s_deferPeriod);
+            continue;
+        }
+
+        uint64_t key = _queue.front();
+        _queue.pop_front();
+
+        lock.unlock();
+
+        uint32_t x, y;
+        inverseMorton2D(key & 0x03ffffffffffffffull, x, y);
+        uint32_t level = static_cast<uint32_t>(key >> 58);
+        size_t bytes = _reader->prefetch(x, y, level, _options);
+
+        lock.lock();
+
+        budget -= double(bytes);
+        if (bytes > 0)
+        {
+            ++_metrics.numPrefetched;
+            _metrics.bytesLoaded += bytes;
+        }
+    }
+}
+
+TilePrefetcher::Metrics TilePrefetcher::getMetrics() const
+{
+    std::scoped_lock<std::mutex> lock(_mutex);
+    return _metrics;
+}
@@ -0,0 +1,167 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsgGIS/TileRenderContext.h>
+
+#include <vsg/core/observer_ptr.h>
+#include <vsg/io/FileSystem.h>
+#include <vsg/io/Logger.h>
+#include <vsg/io/read.h>
+#include <vsg/state/ShaderStage.h>
+
+#include <map>
+#include <mutex>
+
+#include "shaders/simple_tile_frag.cpp"
+#include "shaders/simple_tile_vert.cpp"
+
+using namespace vsgGIS;
+
+namespace
+{
+    const vsg::Path s_vertexShader("shaders/simple_tile.vert");
+    const vsg::Path s_fragmentShader("shaders/simple_tile.frag");
+} // namespace
+
+TileRenderContext::TileRenderContext(const Key& in_key, vsg::ref_ptr<const vsg::Options> options) :
+    key(in_key)
+{
+    vsg::DescriptorSetLayoutBindings descriptorBindings{
+        {0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr} // { binding, descriptorTpe, descriptorCount, stageFlags, pImmutableSamplers}
+    };
+
+    descriptorSetLayout = vsg::DescriptorSetLayout::create(descriptorBindings);
+
+    vsg::PushConstantRanges pushConstantRanges{
+        {VK_SHADER_STAGE_VERTEX_BIT, 0, 128} // projection view, and model matrices, actual push constant calls autoaatically provided by the VSG's DispatchTraversal
+    };
+
+    pipelineLayout = vsg::PipelineLayout::create(vsg::DescriptorSetLayouts{descriptorSetLayout}, pushConstantRanges);
+
+    sampler = vsg::Sampler::create();
+    sampler->maxLod = key.mipmapLevelsHint;
+    sampler->addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler->addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler->addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler->anisotropyEnable = VK_TRUE;
+    sampler->maxAnisotropy = 16.0f;
+
+    vsg::ref_ptr<vsg::ShaderStage> vertexShader;
+    if (!key.vertexShader.empty()) vertexShader = vsg::read_cast<vsg::ShaderStage>(key.vertexShader, options);
+    if (!vertexShader) vertexShader = simple_tile_vert(); // fallback to shaders/simple_tile_vert.cppp
+
+    vsg::ref_ptr<vsg::ShaderStage> fragmentShader;
+    if (!key.fragmentShader.empty()) fragmentShader = vsg::read_cast<vsg::ShaderStage>(key.fragmentShader, options);
+    if (!fragmentShader) fragmentShader = simple_tile_frag(); // fallback to shaders/simple_tile_frag.cppp
+
+    if (!vertexShader || !fragmentShader)
+    {
+        vsg::error("Could not create shaders.");
+    }
+
+    vsg::VertexInputState::Bindings vertexBindingsDescriptions;
+    vsg::VertexInputState::Attributes vertexAttributeDescriptions;
+    if (key.compactVertices)
+    {
+        // 12 bytes per vertex, unorm positions and tex coords are converted to floats on fetch so the float shader inputs are used unchanged
+        vertexBindingsDescriptions = {
+            VkVertexInputBindingDescription{0, sizeof(vsg::usvec4), VK_VERTEX_INPUT_RATE_VERTEX}, // vertex data
+            VkVertexInputBindingDescription{1, sizeof(vsg::vec3), VK_VERTEX_INPUT_RATE_INSTANCE}, // colour data
+            VkVertexInputBindingDescription{2, sizeof(vsg::usvec2), VK_VERTEX_INPUT_RATE_VERTEX}  // tex coord data
+        };
+
+        vertexAttributeDescriptions = {
+            VkVertexInputAttributeDescription{0, 0, VK_FORMAT_R16G16B16A16_UNORM, 0}, // vertex data
+            VkVertexInputAttributeDescription{1, 1, VK_FORMAT_R32G32B32_SFLOAT, 0},   // colour data
+            VkVertexInputAttributeDescription{2, 2, VK_FORMAT_R16G16_UNORM, 0},       // tex coord data
+        };
+    }
+    else
+    {
+        vertexBindingsDescriptions = {
+            VkVertexInputBindingDescription{0, sizeof(vsg::vec3), VK_VERTEX_INPUT_RATE_VERTEX}, // vertex data
+            VkVertexInputBindingDescription{1, sizeof(vsg::vec3), VK_VERTEX_INPUT_RATE_VERTEX}, // colour data
+            VkVertexInputBindingDescription{2, sizeof(vsg::vec2), VK_VERTEX_INPUT_RATE_VERTEX}  // tex coord data
+        };
+
+        vertexAttributeDescriptions = {
+            VkVertexInputAttributeDescription{0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0}, // vertex data
+            VkVertexInputAttributeDescription{1, 1, VK_FORMAT_R32G32B32_SFLOAT, 0}, // colour data
+            VkVertexInputAttributeDescription{2, 2, VK_FORMAT_R32G32_SFLOAT, 0},    // tex coord data
+        };
+    }
+
+    vsg::GraphicsPipelineStates pipelineStates{
+        vsg::VertexInputState::create(vertexBindingsDescriptions, vertexAttributeDescriptions),
+        vsg::InputAssemblyState::create(),
+        vsg::RasterizationState::create(),
+        vsg::MultisampleState::create(),
+        vsg::ColorBlendState::create(),
+        vsg::DepthStencilState::create()};
+
+    graphicsPipeline = vsg::GraphicsPipeline::create(pipelineLayout, vsg::ShaderStages{vertexShader, fragmentShader}, pipelineStates);
+    bindGraphicsPipeline = vsg::BindGraphicsPipeline::create(graphicsPipeline);
+}
+
+TileRenderContext::~TileRenderContext()
+{
+}
+
+TileRenderContext::Key TileRenderContext::createKey(uint32_t mipmapLevelsHint, bool compactVertices, vsg::ref_ptr<const vsg::Options> options)
+{
+    Key key;
+    key.mipmapLevelsHint = mipmapLevelsHint;
+    key.compactVertices = compactVertices;
+    key.vertexShader = vsg::findFile(s_vertexShader, options).string();
+    key.fragmentShader = vsg::findFile(s_fragmentShader, options).string();
+    return key;
+}
+
+vsg::ref_ptr<TileRenderContext> TileRenderContext::get(const Key& key, vsg::ref_ptr<const vsg::Options> options)
+{
+    static std::mutex s_mutex;
+    static std::map<Key, vsg::observer_ptr<TileRenderContext>> s_contexts;
+
+    std::scoped_lock<std::mutex> lock(s_mutex);
+
+    // contexts are only observed so they are released, along with their Vulkan objects, once no TileReader uses them
+    for (auto itr = s_contexts.begin(); itr != s_contexts.end();)
+    {
+        if (itr->second.valid())
+            ++itr;
+        else
+            itr = s_contexts.erase(itr);
+    }
+
+    if (auto itr = s_contexts.find(key); itr != s_contexts.end())
+    {
+        if (auto context = vsg::ref_ptr<TileRenderContext>(itr->second)) return context;
+    }
+
+    auto context = TileRenderContext::create(key, options);
+    s_contexts[key] = vsg::observer_ptr<TileRenderContext>(context);
+
+    vsg::debug("TileRenderContext::get() created context, mipmapLevelsHint = ", key.mipmapLevelsHint, ", compactVertices = ", key.compactVertices);
+
+    return context;
+}
@@ -0,0 +1,190 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsgGIS/TileRequestScheduler.h>
+
+#include <algorithm>
+#include <thread>
+
+using namespace vsgGIS;
+
+namespace
+{
+    // number of PagedLOD tracked between removing the entries of deleted PagedLOD
+    constexpr uint32_t s_prunePeriod = 256;
+
+    // period between waiting requests checking whether they have become stale
+    constexpr std::chrono::milliseconds s_waitPeriod(16);
+
+    double elapsedTime(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::chrono::milliseconds::period>(std::chrono::steady_clock::now() - start).count();
+    }
+} // namespace
+
+TileRequestScheduler::TileRequestScheduler(uint32_t in_maxActiveRequests) :
+    maxActiveRequests(in_maxActiveRequests > 0 ? in_maxActiveRequests : std::max(1u, std::thread::hardware_concurrency()))
+{
+}
+
+TileRequestScheduler::~TileRequestScheduler()
+{
+}
+
+void TileRequestScheduler::track(uint64_t key, vsg::PagedLOD* plod)
+{
+    if (!plod) return;
+
+    std::scoped_lock<std::mutex> lock(_mutex);
+
+    _tracked[key] = vsg::observer_ptr<vsg::PagedLOD>(plod);
+
+    if (++_numTrackedSincePrune >= s_prunePeriod)
+    {
+        for (auto itr = _tracked.begin(); itr != _tracked.end();)
+        {
+            if (itr->second.valid())
+                ++itr;
+            else
+                itr = _tracked.erase(itr);
+        }
+        _numTrackedSincePrune = 0;
+    }
+}
+
+void TileRequestScheduler::advance(uint64_t frameCount)
+{
+    {
+        std::scoped_lock<std::mutex> lock(_mutex);
+        _frameCount = std::max(_frameCount, frameCount);
+    }
+
+    // wake the waiting requests so they recheck whether they have become stale
+    _condition.notify_all();
+}
+
+vsg::ref_ptr<vsg::PagedLOD> TileRequestScheduler::_find(uint64_t key) const
+{
+    auto itr = _tracked.find(key);
+    if (itr == _tracked.end()) return {};
+    return vsg::ref_ptr<vsg::PagedLOD>(itr->second);
+}
+
+bool TileRequestScheduler::_stale(const vsg::PagedLOD* plod)
+{
+    if (!plod) return false;
+
+    uint64_t lastUsed = plod->frameHighResLastUsed;
+    _frameCount = std::max(_frameCount, lastUsed);
+    return _frameCount > lastUsed + staleFrameCount;
+}
+
+bool TileRequestScheduler::_highestPriority(uint64_t id, const Request& request) const
+{
+    double priority = request.plod->priority;
+    for (auto& [waitingId, waiting] : _waiting)
+    {
+        double waitingPriority = waiting.plod->priority;
+        if (waitingPriority > priority || (waitingPriority == priority && waitingId < id)) return false;
+    }
+    return true;
+}
+
+bool TileRequestScheduler::begin(uint64_t key)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    ++_metrics.numRequests;
+
+    Request request{key, _find(key), std::chrono::steady_clock::now()};
+    if (!request.plod)
+    {
+        // nothing to judge priority or staleness by so admit straight away
+        ++_metrics.numUntracked;
+        _active.emplace(key, request);
+        return true;
+    }
+
+    // equal priority requests are admitted in the order they began
+    uint64_t id = _nextRequestId++;
+    _waiting[id] = request;
+    _metrics.maxWaiting = std::max(_metrics.maxWaiting, _waiting.size());
+
+    // the priority of all the waiting requests is re-read on each check so admission follows the latest screen space priority
+    while (true)
+    {
+        if (_stale(request.plod))
+        {
+            ++_metrics.numCancelled[QUEUED];
+            _waiting.erase(id);
+            _condition.notify_all();
+            return false;
+        }
+
+        if (_active.size() < maxActiveRequests && _highestPriority(id, request)) break;
+
+        _condition.wait_for(lock, s_waitPeriod);
+    }
+
+    _waiting.erase(id);
+    _active.emplace(key, request);
+    return true;
+}
+
+bool TileRequestScheduler::proceed(uint64_t key, Stage stage)
+{
+    std::scoped_lock<std::mutex> lock(_mutex);
+
+    auto itr = _active.find(key);
+    if (itr == _active.end() || !_stale(itr->second.plod)) return true;
+
+    ++_metrics.numCancelled[stage];
+    _metrics.wastedTime += elapsedTime(itr->second.startTime);
+    return false;
+}
+
+void TileRequestScheduler::end(uint64_t key, bool completed)
+{
+    {
+        std::scoped_lock<std::mutex> lock(_mutex);
+
+        // requests for the same key are interchangeable, so end only one of them
+        auto itr = _active.find(key);
+        if (itr != _active.end())
+        {
+            _active.erase(itr);
+            if (completed) ++_metrics.numCompleted;
+        }
+    }
+
+    _condition.notify_all();
+}
+
+TileRequestScheduler::Metrics TileRequestScheduler::getMetrics() const
+{
+    std::scoped_lock<std::mutex> lock(_mutex);
+
+    Metrics metrics = _metrics;
+    metrics.numWaiting = _waiting.size();
+    return metrics;
+}
@@ -0,0 +1,306 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsgGIS/TileSeeder.h>
+
+#include <vsg/io/write.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <thread>
+
+using namespace vsgGIS;
+
+namespace
+{
+    struct Rectangle
+    {
+        vsg::dvec2 min;
+        vsg::dvec2 max;
+
+        bool contains(const vsg::dvec2& p) const { return p.x >= min.x && p.x <= max.x && p.y >= min.y && p.y <= max.y; }
+    };
+
+    bool insidePolygon(const std::vector<vsg::dvec2>& polygon, const vsg::dvec2& p)
+    {
+        bool inside = false;
+        for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++)
+        {
+            auto& a = polygon[i];
+            auto& b = polygon[j];
+            if ((a.y > p.y) != (b.y > p.y) && p.x < (b.x - a.x) * (p.y - a.y) / (b.y - a.y) + a.x) inside = !inside;
+        }
+        return inside;
+    }
+
+    double orientation(const vsg::dvec2& a, const vsg::dvec2& b, const vsg::dvec2& c)
+    {
+        return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+    }
+
+    bool segmentsIntersect(const vsg::dvec2& a, const vsg::dvec2& b, const vsg::dvec2& c, const vsg::dvec2& d)
+    {
+        double o1 = orientation(a, b, c);
+        double o2 = orientation(a, b, d);
+        double o3 = orientation(c, d, a);
+        double o4 = orientation(c, d, b);
+        return ((o1 > 0.0) != (o2 > 0.0)) && ((o3 > 0.0) != (o4 > 0.0));
+    }
+
+    bool intersects(const std::vector<vsg::dvec2>& polygon, const Rectangle& rectangle)
+    {
+        for (auto& vertex : polygon)
+        {
+            if (rectangle.contains(vertex)) return true;
+        }
+
+        vsg::dvec2 corners[4] = {rectangle.min, {rectangle.max.x, rectangle.min.y}, rectangle.max, {rectangle.min.x, rectangle.max.y}};
+        for (auto& corner : corners)
+        {
+            if (insidePolygon(polygon, corner)) return true;
+        }
+
+        for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++)
+        {
+            for (size_t c = 0; c < 4; ++c)
+            {
+                if (segmentsIntersect(polygon[j], polygon[i], corners[c], corners[(c + 1) % 4])) return true;
+            }
+        }
+        return false;
+    }
+} // namespace
+
+TileSeeder::TileSeeder(vsg::ref_ptr<TileDatabaseSettings> in_settings) :
+    settings(in_settings)
+{
+}
+
+TileSeeder::~TileSeeder()
+{
+}
+
+std::vector<uint64_t> TileSeeder::computeTiles(const std::vector<vsg::dvec2>& latitudeLongitudePolygon, uint32_t minLevel, uint32_t maxLevel) const
+{
+    std::vector<uint64_t> tiles;
+    if (latitudeLongitudePolygon.size() < 3) return tiles;
+
+    maxLevel = std::min(maxLevel, settings->maxLevel);
+
+    // the intersection tests are done in the coordinate frame of the extents, that tile extents are computed in
+    std::vector<vsg::dvec2> polygon;
+    polygon.reserve(latitudeLongitudePolygon.size());
+    for (auto& latitudeLongitude : latitudeLongitudePolygon)
+    {
+        auto location = settings->computeTileLocation(vsg::dvec3(latitudeLongitude.x, latitudeLongitude.y, 0.0));
+        polygon.emplace_back(location.x, location.y);
+    }
+
+    // descend the quad tree from the root tiles, only visiting the children of tiles that intersect the polygon
+    std::function<void(uint32_t, uint32_t, uint32_t)> visit = [&](uint32_t x, uint32_t y, uint32_t level) {
+        auto extents = settings->computeTileExtents(x, y, level);
+        if (!intersects(polygon, Rectangle{{extents.min.x, extents.min.y}, {extents.max.x, extents.max.y}})) return;
+
+        if (level >= minLevel) tiles.push_back(tileKey(x, y, level));
+
+        if (level < maxLevel)
+        {
+            for (uint32_t i = 0; i < 4; ++i) visit(x * 2 + (i & 1), y * 2 + (i >> 1), level + 1);
+        }
+    };
+
+    for (uint32_t y = 0; y < settings->noY; ++y)
+    {
+        for (uint32_t x = 0; x < settings->noX; ++x)
+        {
+            visit(x, y, 0);
+        }
+    }
+
+    // tileKey order places the tiles of each level together with siblings adjacent
+    std::sort(tiles.begin(), tiles.end());
+    return tiles;
+}
+
+std::vector<uint64_t> TileSeeder::computeTiles(double minLatitude, double minLongitude, double maxLatitude, double maxLongitude, uint32_t minLevel, uint32_t maxLevel) const
+{
+    std::vector<vsg::dvec2> polygon{{minLatitude, minLongitude}, {minLatitude, maxLongitude}, {maxLatitude, maxLongitude}, {maxLatitude, minLongitude}};
+    return computeTiles(polygon, minLevel, maxLevel);
+}
+
+TileSeeder::Progress TileSeeder::seed(const std::vector<uint64_t>& requestedTiles, const vsg::Path& layer, const vsg::Path& output, vsg::ref_ptr<const vsg::Options> options)
+{
+    using clock = std::chrono::steady_clock;
+    auto startTime = clock::now();
+
+    bool writeArchive = vsg::lowerCaseFileExtension(output) == TileArchive::fileExtension;
+
+    // archives are written in tileKey order, without duplicates
+    std::vector<uint64_t> tiles(requestedTiles);
+    if (writeArchive)
+    {
+        std::sort(tiles.begin(), tiles.end());
+        tiles.erase(std::unique(tiles.begin(), tiles.end()), tiles.end());
+    }
+
+    uint32_t threadCount = numThreads > 0 ? numThreads : std::max(1u, std::thread::hardware_concurrency());
+    threadCount = static_cast<uint32_t>(std::min(size_t(threadCount), std::max(size_t(1), tiles.size())));
+
+    // archive tiles are written out as they complete, in tile order, so only a window of decoded tiles is held in memory rather than all of them
+    vsg::ref_ptr<TileArchiveWriter> writer;
+    if (writeArchive)
+    {
+        writer = TileArchiveWriter::create();
+        if (!writer->open(output))
+        {
+            Progress result;
+            result.numTiles = tiles.size();
+            result.numFailed = tiles.size();
+            if (progressCallback) progressCallback(result);
+            return result;
+        }
+    }
+
+    const size_t writeWindow = size_t(threadCount) * 4;
+    std::map<size_t, vsg::ref_ptr<vsg::Data>> readyToWrite;
+    size_t nextWrite = 0;
+
+    std::mutex mutex;
+    std::condition_variable completed;
+    std::condition_variable written;
+    std::atomic_size_t nextTile{0};
+    std::atomic_size_t numCompleted{0};
+    std::atomic_size_t numFailed{0};
+    std::atomic_uint64_t numBytes{0};
+
+    auto seedTiles = [&]() {
+        for (size_t i = nextTile++; i < tiles.size(); i = nextTile++)
+        {
+            if (writeArchive)
+            {
+                // wait for the tiles ahead of this one to be written out before fetching, bounding the number of tiles held in memory
+                std::unique_lock<std::mutex> lock(mutex);
+                written.wait(lock, [&]() { return i < nextWrite + writeWindow; });
+            }
+
+            uint64_t key = tiles[i];
+            uint32_t x, y;
+            inverseMorton2D(key & 0x03ffffffffffffffull, x, y);
+            uint32_t level = static_cast<uint32_t>(key >> 58);
+
+            bool success = false;
+            auto data = vsg::read_cast<vsg::Data>(settings->getTilePath(layer, x, y, level), options);
+            if (data)
+            {
+                numBytes += data->dataSize();
+
+                if (writeArchive)
+                {
+                    success = true;
+                }
+                else
+                {
+                    auto filename = std::filesystem::path(output.string()) / std::to_string(level) / std::to_string(x) / (std::to_string(y) + ".vsgb");
+
+                    std::error_code error;
+                    std::filesystem::create_directories(filename.parent_path(), error);
+                    success = !error && vsg::write(data, vsg::Path(filename.string()), options);
+                }
+            }
+
+            if (writeArchive)
+            {
+                // write out the contiguous run of completed tiles that follows the last tile written
+                std::scoped_lock<std::mutex> lock(mutex);
+                readyToWrite[i] = data;
+                auto itr = readyToWrite.begin();
+                while (itr != readyToWrite.end() && itr->first == nextWrite)
+                {
+                    if (itr->second)
+                    {
+                        uint32_t tx, ty;
+                        inverseMorton2D(tiles[nextWrite] & 0x03ffffffffffffffull, tx, ty);
+                        if (!writer->add(tx, ty, static_cast<uint32_t>(tiles[nextWrite] >> 58), itr->second)) ++numFailed;
+                    }
+                    itr = readyToWrite.erase(itr);
+                    ++nextWrite;
+                }
+                written.notify_all();
+            }
+
+            if (!success) ++numFailed;
+            ++numCompleted;
+        }
+
+        completed.notify_one();
+    };
+
+    auto progress = [&]() {
+        Progress p;
+        p.numTiles = tiles.size();
+        p.numCompleted = numCompleted;
+        p.numFailed = numFailed;
+        p.numBytes = numBytes;
+        p.elapsedTime = std::chrono::duration<double>(clock::now() - startTime).count();
+        return p;
+    };
+
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < threadCount; ++i) threads.emplace_back(seedTiles);
+
+    // report progress from this thread while the workers run
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        auto interval = std::chrono::duration<double>(progressInterval);
+        while (numCompleted < tiles.size())
+        {
+            completed.wait_for(lock, interval);
+
+            if (progressCallback && numCompleted < tiles.size())
+            {
+                lock.unlock();
+                progressCallback(progress());
+                lock.lock();
+            }
+        }
+    }
+
+    for (auto& thread : threads) thread.join();
+
+    if (writeArchive)
+    {
+        if (!writer->close())
+        {
+            vsg::warn("TileSeeder::seed() unable to write ", output);
+            numFailed = tiles.size();
+        }
+    }
+
+    auto result = progress();
+    if (progressCallback) progressCallback(result);
+    return result;
+}
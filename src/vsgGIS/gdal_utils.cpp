@@ -25,11 +25,14 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include <vsg/core/Array2D.h>
 #include <vsg/core/ConstVisitor.h>
+#include <vsg/core/Value.h>
 #include <vsg/core/Visitor.h>
 
+#include <algorithm>
+#include <cmath>
 #include <cstring>
 #include <iostream>
-#include <functional>
+#include <vector>
 
 using namespace vsgGIS;
 
@@ -62,8 +65,13 @@ bool vsgGIS::compatibleDatasetProjections(const GDALDataset& lhs, const GDALData
     // if one of the pointers is NULL then they are incompatible
     if (!lhs_projectionRef || !rhs_projectionRef) return false;
 
-    // check in the OGRSpatialReference are the same
-    return (std::strcmp(lhs_projectionRef, rhs_projectionRef) == 0);
+    if (std::strcmp(lhs_projectionRef, rhs_projectionRef) == 0) return true;
+
+    // different WKT can describe the same coordinate reference system so check if the OGRSpatialReference are the same
+    OGRSpatialReference lhs_srs, rhs_srs;
+    if (lhs_srs.SetFromUserInput(lhs_projectionRef) != OGRERR_NONE || rhs_srs.SetFromUserInput(rhs_projectionRef) != OGRERR_NONE) return false;
+
+    return lhs_srs.IsSame(&rhs_srs);
 }
 
 bool vsgGIS::compatibleDatasetProjectionsTransformAndSizes(const GDALDataset& lhs, const GDALDataset& rhs)
@@ -118,137 +126,265 @@ T default_value(double scale)
     }
 }
 
-template<typename T>
-vsg::t_vec2<T> default_vec2(const vsg::dvec4& value)
+template<class R>
+typename R::value_type default_pixel(const vsg::dvec4& value)
 {
-    return vsg::t_vec2<T>(default_value<T>(value[0]), default_value<T>(value[1]));
+    using T = typename R::component_type;
+    if constexpr (R::numComponents == 1)
+    {
+        return default_value<T>(value[0]);
+    }
+    else
+    {
+        typename R::value_type pixel;
+        for (int i = 0; i < R::numComponents; ++i) pixel[i] = default_value<T>(value[i]);
+        return pixel;
+    }
 }
 
-template<typename T>
-vsg::t_vec3<T> default_vec3(const vsg::dvec4& value)
+vsg::ref_ptr<vsg::Data> vsgGIS::createImage2D(int width, int height, int numComponents, GDALDataType dataType, vsg::dvec4 def)
 {
-    return vsg::t_vec3<T>(default_value<T>(value[0]), default_value<T>(value[1]), default_value<T>(value[2]));
+    return dispatchRasterType(dataType, numComponents, [&](auto rasterType) -> vsg::ref_ptr<vsg::Data> {
+        using R = decltype(rasterType);
+        return R::array_type::create(width, height, default_pixel<R>(def), vsg::Data::Layout{R::format});
+    });
 }
 
-template<typename T>
-vsg::t_vec4<T> default_vec4(const vsg::dvec4& value)
+bool RasterCoverage::empty() const
 {
-    return vsg::t_vec4<T>(default_value<T>(value[0]), default_value<T>(value[1]), default_value<T>(value[2]), default_value<T>(value[4]));
+    return std::all_of(blocks.begin(), blocks.end(), [](uint8_t block) { return block == BLOCK_EMPTY; });
 }
 
-vsg::ref_ptr<vsg::Data> vsgGIS::createImage2D(int width, int height, int numComponents, GDALDataType dataType, vsg::dvec4 def)
+size_t RasterCoverage::count(BlockCoverage coverage) const
+{
+    return std::count(blocks.begin(), blocks.end(), static_cast<uint8_t>(coverage));
+}
+
+void RasterCoverage::merge(const RasterCoverage& rhs)
 {
-    using TypeCompontents = std::pair<GDALDataType, int>;
-    using CreateFunction = std::function<vsg::ref_ptr<vsg::Data>(uint32_t w, uint32_t h, vsg::dvec4 def)>;
-
-    std::map<TypeCompontents, CreateFunction> createMap;
-    createMap[TypeCompontents(GDT_Byte, 1)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::ubyteArray2D::create(w, h, default_value<uint8_t>(d[0]), vsg::Data::Layout{VK_FORMAT_R8_UNORM}); };
-    createMap[TypeCompontents(GDT_UInt16, 1)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::ushortArray2D::create(w, h, default_value<uint16_t>(d[0]), vsg::Data::Layout{VK_FORMAT_R16_UNORM}); };
-    createMap[TypeCompontents(GDT_Int16, 1)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::shortArray2D::create(w, h, default_value<int16_t>(d[0]), vsg::Data::Layout{VK_FORMAT_R16_SNORM}); };
-    createMap[TypeCompontents(GDT_UInt32, 1)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::uintArray2D::create(w, h, default_value<uint32_t>(d[0]), vsg::Data::Layout{VK_FORMAT_R32_UINT}); };
-    createMap[TypeCompontents(GDT_Int32, 1)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::intArray2D::create(w, h, default_value<int32_t>(d[0]), vsg::Data::Layout{VK_FORMAT_R32_SINT}); };
-    createMap[TypeCompontents(GDT_Float32, 1)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::floatArray2D::create(w, h, default_value<float>(d[0]), vsg::Data::Layout{VK_FORMAT_R32_SFLOAT}); };
-    createMap[TypeCompontents(GDT_Float64, 1)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::doubleArray2D::create(w, h, default_value<double>(d[0]), vsg::Data::Layout{VK_FORMAT_R64_SFLOAT}); };
-
-    createMap[TypeCompontents(GDT_Byte, 2)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::ubvec2Array2D::create(w, h, default_vec2<uint8_t>(d), vsg::Data::Layout{VK_FORMAT_R8G8_UNORM}); };
-    createMap[TypeCompontents(GDT_UInt16, 2)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::usvec2Array2D::create(w, h, default_vec2<uint16_t>(d), vsg::Data::Layout{VK_FORMAT_R16G16_UNORM}); };
-    createMap[TypeCompontents(GDT_Int16, 2)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::svec2Array2D::create(w, h, default_vec2<int16_t>(d), vsg::Data::Layout{VK_FORMAT_R16G16_SNORM}); };
-    createMap[TypeCompontents(GDT_UInt32, 2)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::uivec2Array2D::create(w, h, default_vec2<uint32_t>(d), vsg::Data::Layout{VK_FORMAT_R32G32_UINT}); };
-    createMap[TypeCompontents(GDT_Int32, 2)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::ivec2Array2D::create(w, h, default_vec2<int32_t>(d), vsg::Data::Layout{VK_FORMAT_R32G32_SINT}); };
-    createMap[TypeCompontents(GDT_Float32, 2)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::vec2Array2D::create(w, h, default_vec2<float>(d), vsg::Data::Layout{VK_FORMAT_R32G32_SFLOAT}); };
-    createMap[TypeCompontents(GDT_Float64, 2)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::dvec2Array2D::create(w, h, default_vec2<double>(d), vsg::Data::Layout{VK_FORMAT_R64G64_SFLOAT}); };
-
-    createMap[TypeCompontents(GDT_Byte, 3)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::ubvec3Array2D::create(w, h, default_vec3<uint8_t>(d), vsg::Data::Layout{VK_FORMAT_R8G8B8_UNORM}); };
-    createMap[TypeCompontents(GDT_UInt16, 3)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::usvec3Array2D::create(w, h, default_vec3<uint16_t>(d), vsg::Data::Layout{VK_FORMAT_R16G16B16_UNORM}); };
-    createMap[TypeCompontents(GDT_Int16, 3)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::svec3Array2D::create(w, h, default_vec3<int16_t>(d), vsg::Data::Layout{VK_FORMAT_R16G16B16_SNORM}); };
-    createMap[TypeCompontents(GDT_UInt32, 3)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::uivec3Array2D::create(w, h, default_vec3<uint32_t>(d), vsg::Data::Layout{VK_FORMAT_R32G32B32_UINT}); };
-    createMap[TypeCompontents(GDT_Int32, 3)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::ivec3Array2D::create(w, h, default_vec3<int32_t>(d), vsg::Data::Layout{VK_FORMAT_R32G32B32_SINT}); };
-    createMap[TypeCompontents(GDT_Float32, 3)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::vec3Array2D::create(w, h, default_vec3<float>(d), vsg::Data::Layout{VK_FORMAT_R32G32B32_SFLOAT}); };
-    createMap[TypeCompontents(GDT_Float64, 3)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::dvec3Array2D::create(w, h, default_vec3<double>(d), vsg::Data::Layout{VK_FORMAT_R64G64B64_SFLOAT}); };
-
-    createMap[TypeCompontents(GDT_Byte, 4)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::ubvec4Array2D::create(w, h, default_vec4<uint8_t>(d), vsg::Data::Layout{VK_FORMAT_R8G8B8A8_UNORM}); };
-    createMap[TypeCompontents(GDT_UInt16, 4)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::usvec4Array2D::create(w, h, default_vec4<uint16_t>(d), vsg::Data::Layout{VK_FORMAT_R16G16B16A16_UNORM}); };
-    createMap[TypeCompontents(GDT_Int16, 4)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::svec4Array2D::create(w, h, default_vec4<int16_t>(d), vsg::Data::Layout{VK_FORMAT_R16G16B16A16_SNORM}); };
-    createMap[TypeCompontents(GDT_UInt32, 4)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::uivec4Array2D::create(w, h, default_vec4<uint32_t>(d), vsg::Data::Layout{VK_FORMAT_R32G32B32A32_UINT}); };
-    createMap[TypeCompontents(GDT_Int32, 4)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::ivec4Array2D::create(w, h, default_vec4<int32_t>(d), vsg::Data::Layout{VK_FORMAT_R32G32B32A32_SINT}); };
-    createMap[TypeCompontents(GDT_Float32, 4)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::vec4Array2D::create(w, h, default_vec4<float>(d), vsg::Data::Layout{VK_FORMAT_R32G32B32A32_SFLOAT}); };
-    createMap[TypeCompontents(GDT_Float64, 4)] = [](uint32_t w, uint32_t h, vsg::dvec4 d) { return vsg::dvec4Array2D::create(w, h, default_vec4<double>(d), vsg::Data::Layout{VK_FORMAT_R64G64B64A64_SFLOAT}); };
-
-    auto itr = createMap.find(TypeCompontents(dataType, numComponents));
-    if (itr == createMap.end())
+    if (blocks.empty())
     {
-        return {};
+        *this = rhs;
+        return;
     }
 
-    return (itr->second)(width, height, def);
+    if (rhs.numBlocksX != numBlocksX || rhs.numBlocksY != numBlocksY) return;
+
+    // a block only remains empty if it's empty in both
+    for (size_t i = 0; i < blocks.size(); ++i) blocks[i] = std::max(blocks[i], rhs.blocks[i]);
+}
+
+vsg::ref_ptr<vsg::ubyteArray2D> RasterCoverage::createData() const
+{
+    if (blocks.empty()) return {};
+
+    auto data = vsg::ubyteArray2D::create(numBlocksX, numBlocksY, vsg::Data::Layout{VK_FORMAT_R8_UINT});
+    std::copy(blocks.begin(), blocks.end(), data->data());
+    data->setValue("blockWidth", blockWidth);
+    data->setValue("blockHeight", blockHeight);
+    return data;
 }
 
-bool vsgGIS::copyRasterBandToImage(GDALRasterBand& band, vsg::Data& image, int component)
+bool vsgGIS::copyRasterBandToImage(GDALRasterBand& band, vsg::Data& image, int component, RasterCoverage* coverage)
 {
     if (image.width() != static_cast<uint32_t>(band.GetXSize()) || image.height() != static_cast<uint32_t>(band.GetYSize()))
     {
         return false;
     }
 
-    int dataSize = 0;
-    switch (band.GetRasterDataType())
-    {
-    case (GDT_Byte): dataSize = 1; break;
-    case (GDT_UInt16):
-    case (GDT_Int16): dataSize = 2; break;
-    case (GDT_UInt32):
-    case (GDT_Int32):
-    case (GDT_Float32): dataSize = 4; break;
-    case (GDT_Float64): dataSize = 8; break;
-    default:
-        return false;
-    }
+    int hasNoData = FALSE;
+    double noDataValue = band.GetNoDataValue(&hasNoData);
 
-    int offset = dataSize * component;
-    int stride = image.getLayout().stride;
+    return dispatchDataType(band.GetRasterDataType(), [&](auto value) -> bool {
+        using T = decltype(value);
+
+        size_t offset = sizeof(T) * component;
+        size_t stride = image.getLayout().stride;
+        if (offset + sizeof(T) > stride) return false;
 
-    int nBlockXSize, nBlockYSize;
-    band.GetBlockSize(&nBlockXSize, &nBlockYSize);
+        // a NoData value the data type can't hold never occurs in the band, so is ignored
+        bool validNoData = hasNoData && isRepresentable<T>(noDataValue);
 
-    int nXBlocks = (band.GetXSize() + nBlockXSize - 1) / nBlockXSize;
-    int nYBlocks = (band.GetYSize() + nBlockYSize - 1) / nBlockYSize;
+        // value that GDAL returns for blocks with no data
+        bool noDataIsNaN = validNoData && std::isnan(noDataValue);
+        T fillValue = validNoData ? static_cast<T>(noDataValue) : T(0);
+        auto isNoData = [&](T v) {
+            if constexpr (std::is_floating_point_v<T>)
+            {
+                if (noDataIsNaN) return std::isnan(v);
+            }
+            return v == fillValue;
+        };
 
-    uint8_t* block = new uint8_t[dataSize * nBlockXSize * nBlockYSize];
+        int nBlockXSize, nBlockYSize;
+        band.GetBlockSize(&nBlockXSize, &nBlockYSize);
 
-    for (int iYBlock = 0; iYBlock < nYBlocks; iYBlock++)
-    {
-        for (int iXBlock = 0; iXBlock < nXBlocks; iXBlock++)
+        int nXBlocks = (band.GetXSize() + nBlockXSize - 1) / nBlockXSize;
+        int nYBlocks = (band.GetYSize() + nBlockYSize - 1) / nBlockYSize;
+
+        if (coverage)
+        {
+            coverage->blockWidth = nBlockXSize;
+            coverage->blockHeight = nBlockYSize;
+            coverage->numBlocksX = nXBlocks;
+            coverage->numBlocksY = nYBlocks;
+            coverage->blocks.assign(static_cast<size_t>(nXBlocks) * nYBlocks, BLOCK_FULL);
+        }
+
+        std::vector<T> block(static_cast<size_t>(nBlockXSize) * nBlockYSize);
+
+        for (int iYBlock = 0; iYBlock < nYBlocks; iYBlock++)
         {
-            int nXValid, nYValid;
-            CPLErr result = band.ReadBlock(iXBlock, iYBlock, block);
-            if (result == 0)
+            for (int iXBlock = 0; iXBlock < nXBlocks; iXBlock++)
             {
                 // Compute the portion of the block that is valid
                 // for partial edge blocks.
+                int nXValid, nYValid;
                 band.GetActualBlockSize(iXBlock, iYBlock, &nXValid, &nYValid);
 
+                BlockCoverage blockCoverage = BLOCK_FULL;
+
+#if GDAL_VERSION_NUM >= 2020000
+                // sparse files report blocks that have never been written so they can be skipped without reading or decompressing them
+                int status = band.GetDataCoverageStatus(iXBlock * nBlockXSize, iYBlock * nBlockYSize, nXValid, nYValid, 0, nullptr);
+                if ((status & GDAL_DATA_COVERAGE_STATUS_EMPTY) != 0 && (status & GDAL_DATA_COVERAGE_STATUS_DATA) == 0)
+                {
+                    blockCoverage = BLOCK_EMPTY;
+                    std::fill(block.begin(), block.end(), fillValue);
+                }
+                else
+#endif
+                {
+                    if (band.ReadBlock(iXBlock, iYBlock, block.data()) != CE_None)
+                    {
+                        // the block's contents and coverage are unknown, so the image can't be trusted
+                        return false;
+                    }
+
+                    // the per pixel scan is only needed to report the coverage
+                    if (coverage && validNoData)
+                    {
+                        size_t numNoData = 0;
+                        for (int iY = 0; iY < nYValid; iY++)
+                        {
+                            const T* source_ptr = block.data() + static_cast<size_t>(iY) * nBlockXSize;
+                            for (int iX = 0; iX < nXValid; iX++)
+                            {
+                                if (isNoData(source_ptr[iX])) ++numNoData;
+                            }
+                        }
+
+                        if (numNoData == static_cast<size_t>(nXValid) * nYValid)
+                            blockCoverage = BLOCK_EMPTY;
+                        else if (numNoData > 0)
+                            blockCoverage = BLOCK_PARTIAL;
+                    }
+                }
+
+                if (coverage) coverage->blocks[static_cast<size_t>(iYBlock) * nXBlocks + iXBlock] = blockCoverage;
+
                 for (int iY = 0; iY < nYValid; iY++)
                 {
                     uint8_t* dest_ptr = reinterpret_cast<uint8_t*>(image.dataPointer(iXBlock * nBlockXSize + (iYBlock * nBlockYSize + iY) * image.width())) + offset;
-                    uint8_t* source_ptr = block + iY * nBlockXSize * dataSize;
+                    const T* source_ptr = block.data() + static_cast<size_t>(iY) * nBlockXSize;
 
-                    for (int iX = 0; iX < nXValid; iX++)
+                    if (stride == sizeof(T))
+                    {
+                        // single component images have the same layout as the block so copy whole rows
+                        std::memcpy(dest_ptr, source_ptr, sizeof(T) * nXValid);
+                    }
+                    else
                     {
-                        for (int c = 0; c < dataSize; ++c)
+                        for (int iX = 0; iX < nXValid; iX++)
                         {
-                            dest_ptr[c] = *source_ptr;
-                            ++source_ptr;
+                            std::memcpy(dest_ptr, source_ptr + iX, sizeof(T));
+                            dest_ptr += stride;
                         }
-
-                        dest_ptr += stride;
                     }
                 }
             }
         }
+
+        if (hasNoData) image.setValue("NoDataValue", noDataValue);
+
+        return true;
+    });
+}
+
+GDALRasterBand* vsgGIS::selectOverview(GDALRasterBand& band, int xSize, int ySize, int width, int height)
+{
+    if (width <= 0 || height <= 0) return &band;
+
+    // decimation that can be applied while still providing enough source pixels for the output
+    double requiredDecimation = std::min(double(xSize) / double(width), double(ySize) / double(height));
+    if (requiredDecimation <= 1.0) return &band;
+
+    GDALRasterBand* bestBand = &band;
+    double bestDecimation = 1.0;
+
+    for (int i = 0; i < band.GetOverviewCount(); ++i)
+    {
+        GDALRasterBand* overview = band.GetOverview(i);
+        if (!overview || overview->GetXSize() <= 0 || overview->GetYSize() <= 0) continue;
+
+        double decimation = std::max(double(band.GetXSize()) / double(overview->GetXSize()), double(band.GetYSize()) / double(overview->GetYSize()));
+
+        // allow for the rounding of overview dimensions
+        if (decimation <= requiredDecimation * 1.01 && decimation > bestDecimation)
+        {
+            bestBand = overview;
+            bestDecimation = decimation;
+        }
     }
-    delete[] block;
 
-    return true;
+    return bestBand;
+}
+
+bool vsgGIS::readRasterBandWindowToImage(GDALRasterBand& band, int xOff, int yOff, int xSize, int ySize, vsg::Data& image, int component, ResampleMethod method)
+{
+    if (xOff < 0 || yOff < 0 || xSize <= 0 || ySize <= 0 || (xOff + xSize) > band.GetXSize() || (yOff + ySize) > band.GetYSize())
+    {
+        return false;
+    }
+
+    GDALDataType dataType = band.GetRasterDataType();
+    int dataSize = GDALGetDataTypeSizeBytes(dataType);
+    int stride = image.getLayout().stride;
+    if (dataSize == 0 || (component + 1) * dataSize > stride) return false;
+
+    int width = static_cast<int>(image.width());
+    int height = static_cast<int>(image.height());
+
+    GDALRasterBand* source = selectOverview(band, xSize, ySize, width, height);
+
+    // map the full resolution window onto the chosen overview
+    double xScale = double(source->GetXSize()) / double(band.GetXSize());
+    double yScale = double(source->GetYSize()) / double(band.GetYSize());
+
+    GDALRasterIOExtraArg extraArg;
+    INIT_RASTERIO_EXTRA_ARG(extraArg);
+    switch (method)
+    {
+    case (RESAMPLE_AVERAGE): extraArg.eResampleAlg = GRIORA_Average; break;
+    case (RESAMPLE_BILINEAR): extraArg.eResampleAlg = GRIORA_Bilinear; break;
+    default: extraArg.eResampleAlg = GRIORA_NearestNeighbour; break;
+    }
+    extraArg.bFloatingPointWindowValidity = TRUE;
+    extraArg.dfXOff = double(xOff) * xScale;
+    extraArg.dfYOff = double(yOff) * yScale;
+    extraArg.dfXSize = double(xSize) * xScale;
+    extraArg.dfYSize = double(ySize) * yScale;
+
+    int sourceXOff = std::min(static_cast<int>(extraArg.dfXOff), source->GetXSize() - 1);
+    int sourceYOff = std::min(static_cast<int>(extraArg.dfYOff), source->GetYSize() - 1);
+    int sourceXSize = std::max(1, std::min(static_cast<int>(std::ceil(extraArg.dfXOff + extraArg.dfXSize)), source->GetXSize()) - sourceXOff);
+    int sourceYSize = std::max(1, std::min(static_cast<int>(std::ceil(extraArg.dfYOff + extraArg.dfYSize)), source->GetYSize()) - sourceYOff);
+
+    // write directly into the target component, GDAL handles the interleaving with the pixel and line spacing
+    uint8_t* dest_ptr = reinterpret_cast<uint8_t*>(image.dataPointer()) + dataSize * component;
+    CPLErr result = source->RasterIO(GF_Read, sourceXOff, sourceYOff, sourceXSize, sourceYSize, dest_ptr, width, height, dataType, stride, static_cast<GSpacing>(stride) * width, &extraArg);
+
+    return result == CE_None;
 }
 
 bool vsgGIS::assignMetaData(GDALDataset& dataset, vsg::Object& object)
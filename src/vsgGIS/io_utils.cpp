@@ -0,0 +1,65 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsgGIS/io_utils.h>
+
+#include <vsg/io/VSG.h>
+#include <vsg/io/read.h>
+
+using namespace vsgGIS;
+
+namespace
+{
+    bool canReadStream(const vsg::ReaderWriter& rw, const vsg::Path& extension)
+    {
+        vsg::ReaderWriter::Features features;
+        if (!rw.getFeatures(features)) return false;
+
+        auto itr = features.extensionFeatureMap.find(extension);
+        return itr != features.extensionFeatureMap.end() && (itr->second & vsg::ReaderWriter::READ_ISTREAM) != 0;
+    }
+} // namespace
+
+bool vsgGIS::canDecodeData(const vsg::Path& extension, vsg::ref_ptr<const vsg::Options> options)
+{
+    if (options)
+    {
+        for (auto& rw : options->readerWriters)
+        {
+            if (rw && canReadStream(*rw, extension)) return true;
+        }
+    }
+
+    // vsg::read(..) falls back to the native .vsgb/.vsgt ReaderWriter
+    return canReadStream(*vsg::VSG::create(), extension);
+}
+
+vsg::ref_ptr<vsg::Data> vsgGIS::decodeData(const uint8_t* ptr, size_t size, const vsg::Path& extension, vsg::ref_ptr<const vsg::Options> options)
+{
+    auto local_options = options ? vsg::Options::create(*options) : vsg::Options::create();
+    local_options->extensionHint = extension;
+
+    memory_streambuf buffer(ptr, size);
+    std::istream fin(&buffer);
+    return vsg::read_cast<vsg::Data>(fin, local_options);
+}
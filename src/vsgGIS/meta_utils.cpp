@@ -25,13 +25,103 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <vsg/io/Logger.h>
 #include <vsgGIS/meta_utils.h>
 
+#include <algorithm>
+#include <cmath>
 #include <cstring>
 
 using namespace vsgGIS;
 
-bool vsgGIS::getEXIF_LatitudeLongitudeAlititude(GDALDataset& dataset, double& latitude, double& longitude, double& altitude)
+const char* vsgGIS::parseNumber(const char* str, double& value)
+{
+    if (!str) return nullptr;
+
+    while (*str == ' ') ++str;
+
+    bool bracketed = (*str == '(');
+    if (bracketed)
+    {
+        ++str;
+        while (*str == ' ') ++str;
+    }
+
+    bool negative = (*str == '-');
+    if (*str == '-' || *str == '+') ++str;
+
+    auto isDigit = [](char c) { return c >= '0' && c <= '9'; };
+
+    bool hasDigits = false;
+    double result = 0.0;
+    for (; isDigit(*str); ++str, hasDigits = true) result = result * 10.0 + double(*str - '0');
+
+    if (*str == '.')
+    {
+        // accumulate the fraction as an integer to avoid compounding rounding errors
+        ++str;
+        uint64_t fraction = 0;
+        double divisor = 1.0;
+        for (; isDigit(*str); ++str, hasDigits = true)
+        {
+            if (divisor < 1e18)
+            {
+                fraction = fraction * 10 + uint64_t(*str - '0');
+                divisor *= 10.0;
+            }
+        }
+        result += double(fraction) / divisor;
+    }
+
+    if (!hasDigits) return nullptr;
+
+    if ((*str == 'e' || *str == 'E') && (isDigit(str[1]) || ((str[1] == '-' || str[1] == '+') && isDigit(str[2]))))
+    {
+        ++str;
+        bool negativeExponent = (*str == '-');
+        if (*str == '-' || *str == '+') ++str;
+
+        int exponent = 0;
+        for (; isDigit(*str); ++str) exponent = std::min(exponent * 10 + (*str - '0'), 1000);
+        result *= std::pow(10.0, negativeExponent ? -exponent : exponent);
+    }
+
+    if (bracketed)
+    {
+        while (*str == ' ') ++str;
+        if (*str == ')') ++str;
+    }
+
+    value = negative ? -result : result;
+    return str;
+}
+
+const char* vsgGIS::parseDMS(const char* str, double& value)
+{
+    double degrees = 0.0, minutes = 0.0, seconds = 0.0;
+    str = parseNumber(str, degrees);
+    if (!str) return nullptr;
+
+    if (auto next = parseNumber(str, minutes))
+    {
+        str = next;
+        if (next = parseNumber(str, seconds); next) str = next;
+    }
+
+    double magnitude = std::abs(degrees) + (minutes + seconds / 60.0) / 60.0;
+    value = degrees < 0.0 ? -magnitude : magnitude;
+    return str;
+}
+
+namespace
+{
+    // apply a EXIF_GPSLatitudeRef or EXIF_GPSLongitudeRef, southern and western references negate the angle
+    void applyReference(const char* reference, double& angle)
+    {
+        while (*reference == ' ' || *reference == '(') ++reference;
+        if ((*reference == 'S' || *reference == 's' || *reference == 'W' || *reference == 'w') && angle > 0.0) angle = -angle;
+    }
+} // namespace
+
+bool vsgGIS::getEXIF_LatitudeLongitudeAlititude(char** metaData, double& latitude, double& longitude, double& altitude)
 {
-    auto metaData = dataset.GetMetadata();
     if (!metaData) return false;
 
     auto match = [](const char* lhs, const char* rhs) -> const char* {
@@ -43,68 +133,67 @@ bool vsgGIS::getEXIF_LatitudeLongitudeAlititude(GDALDataset& dataset, double& la
     };
 
     bool success = false;
+    const char* latitudeRef = nullptr;
+    const char* longitudeRef = nullptr;
 
     const char* value_str = nullptr;
-    std::stringstream str;
-    str.imbue(std::locale::classic());
-
     for (auto ptr = metaData; *ptr != 0; ++ptr)
     {
+        // all the GPS entries share the same prefix so skip the rest quickly
+        if (strncmp(*ptr, "EXIF_GPS", 8) != 0) continue;
+
         if (value_str = match(*ptr, "EXIF_GPSLatitude="); value_str)
         {
-            str.clear();
-            str.str(value_str);
-            str >> vsgGIS::dms_in_brackets(latitude);
-            success = true;
+            if (parseDMS(value_str, latitude)) success = true;
         }
         else if (value_str = match(*ptr, "EXIF_GPSLongitude="); value_str)
         {
-            str.clear();
-            str.str(value_str);
-            str >> vsgGIS::dms_in_brackets(longitude);
-            success = true;
+            if (parseDMS(value_str, longitude)) success = true;
         }
         else if (value_str = match(*ptr, "EXIF_GPSAltitude="); value_str)
         {
-            str.clear();
-            str.str(value_str);
-            str >> vsgGIS::dms_in_brackets(altitude);
-            success = true;
+            if (parseNumber(value_str, altitude)) success = true;
+        }
+        else if (value_str = match(*ptr, "EXIF_GPSLatitudeRef="); value_str)
+        {
+            latitudeRef = value_str;
+        }
+        else if (value_str = match(*ptr, "EXIF_GPSLongitudeRef="); value_str)
+        {
+            longitudeRef = value_str;
         }
     }
 
+    if (latitudeRef) applyReference(latitudeRef, latitude);
+    if (longitudeRef) applyReference(longitudeRef, longitude);
+
     return success;
 }
 
+bool vsgGIS::getEXIF_LatitudeLongitudeAlititude(GDALDataset& dataset, double& latitude, double& longitude, double& altitude)
+{
+    return getEXIF_LatitudeLongitudeAlititude(dataset.GetMetadata(), latitude, longitude, altitude);
+}
+
 bool vsgGIS::getEXIF_LatitudeLongitudeAlititude(const vsg::Object& object, double& latitude, double& longitude, double& altitude)
 {
     bool success = false;
 
     std::string value_str;
-    std::stringstream str;
-    str.imbue(std::locale::classic());
-
-    if (object.getValue("EXIF_GPSLatitude", value_str))
+    if (object.getValue("EXIF_GPSLatitude", value_str) && parseDMS(value_str.c_str(), latitude))
     {
-        str.clear();
-        str.str(value_str);
-        str >> vsgGIS::dms_in_brackets(latitude);
+        if (std::string ref_str; object.getValue("EXIF_GPSLatitudeRef", ref_str)) applyReference(ref_str.c_str(), latitude);
         vsg::info("vsgGA::getEXIF_..    EXIF_GPSLatitude = ", value_str, " degrees = ", latitude);
         success = true;
     }
-    if (object.getValue("EXIF_GPSLongitude", value_str))
+    if (object.getValue("EXIF_GPSLongitude", value_str) && parseDMS(value_str.c_str(), longitude))
     {
-        str.clear();
-        str.str(value_str);
-        str >> vsgGIS::dms_in_brackets(longitude);
+        if (std::string ref_str; object.getValue("EXIF_GPSLongitudeRef", ref_str)) applyReference(ref_str.c_str(), longitude);
         vsg::info("vsgGA::getEXIF_..    EXIF_GPSLongitude = ", value_str, " degrees = ", longitude);
         success = true;
     }
-    if (object.getValue("EXIF_GPSAltitude", value_str))
+    if (object.getValue("EXIF_GPSAltitude", value_str) && parseNumber(value_str.c_str(), altitude))
     {
-        str.clear();
-        str.str(value_str);
-        str >> vsgGIS::in_brackets(altitude);
         vsg::info("vsgGA::getEXIF_..    EXIF_GPSAltitude = ", value_str, " altitude = ", altitude);
         success = true;
     }
@@ -0,0 +1,535 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2021 Robert Osfield
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsgGIS/raster_utils.h>
+
+#include <vsg/core/Value.h>
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#    include <immintrin.h>
+#    define VSGGIS_SSE2
+#endif
+
+// F16C isn't part of the x86-64 baseline, so unless the build targets it the conversion kernel is compiled for it separately and selected at runtime
+#if defined(__F16C__) && defined(__AVX__)
+#    define VSGGIS_F16C
+#elif defined(VSGGIS_SSE2) && (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#    define VSGGIS_F16C
+#    define VSGGIS_F16C_TARGET __attribute__((target("avx,f16c")))
+#endif
+
+using namespace vsgGIS;
+
+namespace
+{
+    // number of values below which it's not worth spreading work across threads
+    constexpr size_t s_minValuesPerThread = 1 << 16;
+
+    // call func(begin, end) over count values, splitting the range across threads when it's large enough to benefit.
+    template<typename F>
+    void parallel_ranges(size_t count, F func)
+    {
+        size_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+        size_t numThreads = std::min(maxThreads, count / s_minValuesPerThread);
+        if (numThreads <= 1)
+        {
+            func(size_t(0), count, size_t(0));
+            return;
+        }
+
+        size_t rangeSize = (count + numThreads - 1) / numThreads;
+
+        std::vector<std::thread> threads;
+        threads.reserve(numThreads - 1);
+        for (size_t i = 1; i < numThreads; ++i)
+        {
+            size_t begin = std::min(count, i * rangeSize);
+            size_t end = std::min(count, begin + rangeSize);
+            threads.emplace_back([&func, begin, end, i]() { func(begin, end, i); });
+        }
+
+        // the calling thread does the first range
+        func(size_t(0), std::min(count, rangeSize), size_t(0));
+
+        for (auto& thread : threads) thread.join();
+    }
+
+#if defined(VSGGIS_F16C)
+#    if defined(VSGGIS_F16C_TARGET)
+    bool supportsF16C()
+    {
+        static const bool supported = __builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c");
+        return supported;
+    }
+#    else
+#        define VSGGIS_F16C_TARGET
+    constexpr bool supportsF16C() { return true; }
+#    endif
+
+    // convert the 32 byte aligned values to half floats 8 at a time, returning the number converted. Only call when supportsF16C().
+    VSGGIS_F16C_TARGET size_t floatsToHalfF16C(const float* values, uint16_t* dest, size_t n)
+    {
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8)
+        {
+            __m128i halfs = _mm256_cvtps_ph(_mm256_load_ps(values + i), _MM_FROUND_TO_NEAREST_INT);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), halfs);
+        }
+        return i;
+    }
+#endif
+
+    template<typename T>
+    inline T read_value(const uint8_t* ptr)
+    {
+        T value;
+        std::memcpy(&value, ptr, sizeof(T));
+        return value;
+    }
+
+    template<typename T>
+    ValueRange reduce_range(const uint8_t* ptr, size_t stride, size_t begin, size_t end, const double* noDataValue)
+    {
+        ValueRange range;
+        size_t i = begin;
+
+#if defined(VSGGIS_SSE2)
+        if constexpr (std::is_same_v<T, float>)
+        {
+            if (stride == sizeof(float))
+            {
+                // minps/maxps return their second operand when the first is NaN, so passing the values first skips NaN
+                const float* values = reinterpret_cast<const float*>(ptr);
+                __m128 vmin = _mm_set1_ps(std::numeric_limits<float>::infinity());
+                __m128 vmax = _mm_set1_ps(-std::numeric_limits<float>::infinity());
+                __m128 positiveInf = vmin;
+                __m128 negativeInf = vmax;
+                __m128 noData = _mm_set1_ps(noDataValue ? static_cast<float>(*noDataValue) : 0.0f);
+
+                for (; i + 4 <= end; i += 4)
+                {
+                    __m128 v = _mm_loadu_ps(values + i);
+                    if (noDataValue)
+                    {
+                        __m128 valid = _mm_cmpneq_ps(v, noData);
+                        vmin = _mm_min_ps(_mm_or_ps(_mm_and_ps(valid, v), _mm_andnot_ps(valid, positiveInf)), vmin);
+                        vmax = _mm_max_ps(_mm_or_ps(_mm_and_ps(valid, v), _mm_andnot_ps(valid, negativeInf)), vmax);
+                    }
+                    else
+                    {
+                        vmin = _mm_min_ps(v, vmin);
+                        vmax = _mm_max_ps(v, vmax);
+                    }
+                }
+
+                alignas(16) float minimums[4];
+                alignas(16) float maximums[4];
+                _mm_store_ps(minimums, vmin);
+                _mm_store_ps(maximums, vmax);
+                for (int c = 0; c < 4; ++c)
+                {
+                    if (minimums[c] <= maximums[c])
+                    {
+                        range.minimum = std::min(range.minimum, double(minimums[c]));
+                        range.maximum = std::max(range.maximum, double(maximums[c]));
+                    }
+                }
+            }
+        }
+#endif
+
+        for (; i < end; ++i)
+        {
+            double value = static_cast<double>(read_value<T>(ptr + i * stride));
+            if (std::isnan(value) || (noDataValue && value == *noDataValue)) continue;
+            if (value < range.minimum) range.minimum = value;
+            if (value > range.maximum) range.maximum = value;
+        }
+
+        return range;
+    }
+
+    struct ComponentAccess
+    {
+        const uint8_t* ptr = nullptr;
+        size_t stride = 0;
+        size_t count = 0;
+    };
+
+    template<class R>
+    bool componentAccess(const vsg::Data& data, int component, ComponentAccess& access)
+    {
+        using T = typename R::component_type;
+        if (component < 0 || component >= R::numComponents) return false;
+
+        access.stride = data.getLayout().stride > 0 ? data.getLayout().stride : data.valueSize();
+        access.ptr = reinterpret_cast<const uint8_t*>(data.dataPointer()) + sizeof(T) * component;
+        access.count = static_cast<size_t>(data.width()) * data.height() * data.depth();
+        return access.ptr != nullptr;
+    }
+
+    vsg::ref_ptr<vsg::ushortArray2D> createUShortImage(const vsg::Data& data, VkFormat format)
+    {
+        vsg::Data::Layout layout;
+        layout.format = format;
+        layout.origin = data.getLayout().origin;
+        return vsg::ushortArray2D::create(data.width(), data.height() * data.depth(), layout);
+    }
+} // namespace
+
+ValueRange vsgGIS::computeValueRange(const vsg::Data& data, int component, const double* noDataValue)
+{
+    return dispatchImageFormat(data.getLayout().format, [&](auto rasterType) -> ValueRange {
+        using R = decltype(rasterType);
+        using T = typename R::component_type;
+
+        ComponentAccess access;
+        if (!componentAccess<R>(data, component, access)) return {};
+
+        // each thread reduces its own range which are then merged
+        std::vector<ValueRange> ranges(std::max(1u, std::thread::hardware_concurrency()));
+        parallel_ranges(access.count, [&](size_t begin, size_t end, size_t index) {
+            ranges[index] = reduce_range<T>(access.ptr, access.stride, begin, end, noDataValue);
+        });
+
+        ValueRange range;
+        for (auto& r : ranges) range.expandBy(r);
+        return range;
+    });
+}
+
+ValueRange vsgGIS::computeValueRange(GDALRasterBand& band, bool approximate)
+{
+    double minmax[2];
+    if (band.ComputeRasterMinMax(approximate ? TRUE : FALSE, minmax) != CE_None) return {};
+
+    return ValueRange{minmax[0], minmax[1]};
+}
+
+vsg::ref_ptr<vsg::Data> vsgGIS::convertToHalfFloat(const vsg::Data& data, int component, double offset, const double* noDataValue)
+{
+    auto image = dispatchImageFormat(data.getLayout().format, [&](auto rasterType) -> vsg::ref_ptr<vsg::Data> {
+        using R = decltype(rasterType);
+        using T = typename R::component_type;
+
+        ComponentAccess access;
+        if (!componentAccess<R>(data, component, access)) return {};
+
+        auto halfImage = createUShortImage(data, VK_FORMAT_R16_SFLOAT);
+        uint16_t* dest = halfImage->data();
+
+        parallel_ranges(access.count, [&](size_t begin, size_t end, size_t) {
+            // gather the component into a small float buffer that the conversion can then process with wide instructions
+            constexpr size_t chunkSize = 256;
+            alignas(32) float values[chunkSize];
+
+            for (size_t chunkBegin = begin; chunkBegin < end; chunkBegin += chunkSize)
+            {
+                size_t chunkEnd = std::min(end, chunkBegin + chunkSize);
+                size_t n = chunkEnd - chunkBegin;
+
+                const uint8_t* src = access.ptr + chunkBegin * access.stride;
+                for (size_t i = 0; i < n; ++i, src += access.stride)
+                {
+                    double value = static_cast<double>(read_value<T>(src));
+                    values[i] = (noDataValue && value == *noDataValue) ? std::numeric_limits<float>::quiet_NaN() : static_cast<float>(value - offset);
+                }
+
+                size_t i = 0;
+#if defined(VSGGIS_F16C)
+                if (supportsF16C()) i = floatsToHalfF16C(values, dest + chunkBegin, n);
+#endif
+                for (; i < n; ++i) dest[chunkBegin + i] = floatToHalf(values[i]);
+            }
+        });
+
+        return halfImage;
+    });
+
+    if (image)
+    {
+        image->setValue("offset", offset);
+        image->setValue("scale", 1.0);
+    }
+
+    return image;
+}
+
+vsg::ref_ptr<vsg::Data> vsgGIS::quantizeToUNorm16(const vsg::Data& data, const ValueRange& range, int component, const double* noDataValue)
+{
+    if (!range.valid()) return {};
+
+    // when a noDataValue is used 0 is reserved for it and valid values are mapped to 1 to 65535
+    const double quantizedBase = noDataValue ? 1.0 : 0.0;
+    const double quantizedRange = 65535.0 - quantizedBase;
+    const double valueRange = range.maximum - range.minimum;
+    const double multiplier = valueRange > 0.0 ? quantizedRange / valueRange : 0.0;
+
+    auto image = dispatchImageFormat(data.getLayout().format, [&](auto rasterType) -> vsg::ref_ptr<vsg::Data> {
+        using R = decltype(rasterType);
+        using T = typename R::component_type;
+
+        ComponentAccess access;
+        if (!componentAccess<R>(data, component, access)) return {};
+
+        auto unormImage = createUShortImage(data, VK_FORMAT_R16_UNORM);
+        uint16_t* dest = unormImage->data();
+
+        parallel_ranges(access.count, [&](size_t begin, size_t end, size_t) {
+            const uint8_t* src = access.ptr + begin * access.stride;
+            for (size_t i = begin; i < end; ++i, src += access.stride)
+            {
+                double value = static_cast<double>(read_value<T>(src));
+                double quantized = quantizedBase + (value - range.minimum) * multiplier + 0.5;
+                quantized = std::min(65535.0, std::max(quantizedBase, quantized));
+                dest[i] = (noDataValue && (value == *noDataValue || std::isnan(value))) ? uint16_t(0) : static_cast<uint16_t>(quantized);
+            }
+        });
+
+        return unormImage;
+    });
+
+    if (image)
+    {
+        // sample = quantized / 65535, value = minimum + (quantized - quantizedBase) / multiplier
+        double scale = valueRange > 0.0 ? 65535.0 * valueRange / quantizedRange : 0.0;
+        double offset = range.minimum - quantizedBase * (valueRange > 0.0 ? valueRange / quantizedRange : 0.0);
+        image->setValue("offset", offset);
+        image->setValue("scale", scale);
+
+        // record that sample 0 is reserved for NoData so readers test the raw sample before decoding it
+        if (noDataValue) image->setValue("NoDataSample", 0.0);
+    }
+
+    return image;
+}
+
+namespace
+{
+    struct PixelFormat
+    {
+        uint32_t numComponents = 0;
+        bool bgr = false;
+        VkFormat compositeFormat = VK_FORMAT_UNDEFINED; // 4 component format with the same channel order and encoding
+    };
+
+    bool pixelFormat(VkFormat format, PixelFormat& pixelFormat)
+    {
+        switch (format)
+        {
+        case VK_FORMAT_R8G8B8_UNORM: pixelFormat = PixelFormat{3, false, VK_FORMAT_R8G8B8A8_UNORM}; return true;
+        case VK_FORMAT_R8G8B8_SRGB: pixelFormat = PixelFormat{3, false, VK_FORMAT_R8G8B8A8_SRGB}; return true;
+        case VK_FORMAT_B8G8R8_UNORM: pixelFormat = PixelFormat{3, true, VK_FORMAT_B8G8R8A8_UNORM}; return true;
+        case VK_FORMAT_B8G8R8_SRGB: pixelFormat = PixelFormat{3, true, VK_FORMAT_B8G8R8A8_SRGB}; return true;
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_R8G8B8A8_SRGB: pixelFormat = PixelFormat{4, false, format}; return true;
+        case VK_FORMAT_B8G8R8A8_UNORM:
+        case VK_FORMAT_B8G8R8A8_SRGB: pixelFormat = PixelFormat{4, true, format}; return true;
+        default: return false;
+        }
+    }
+
+    size_t pixelStride(const vsg::Data& data)
+    {
+        return data.getLayout().stride > 0 ? data.getLayout().stride : data.valueSize();
+    }
+
+    // exact x / 255 rounded to nearest for x in the range 0 to 65025
+    inline uint32_t div255(uint32_t x)
+    {
+        x += 128;
+        return (x + (x >> 8)) >> 8;
+    }
+
+    inline uint32_t blendComponent(uint32_t below, uint32_t layer, BlendMode blendMode)
+    {
+        switch (blendMode)
+        {
+        case BLEND_MULTIPLY: return div255(layer * below);
+        case BLEND_SCREEN: return layer + below - div255(layer * below);
+        case BLEND_ADD: return std::min(255u, layer + below);
+        default: return layer;
+        }
+    }
+
+    // blend a row of 4 component 8 bit source pixels onto dest, opacity is in the range 0 to 255.
+    // All arithmetic is done in integers so the SSE2 and scalar paths give identical results.
+    void blend_row(uint8_t* dest, const uint8_t* src, size_t numPixels, uint32_t opacity, BlendMode blendMode)
+    {
+        size_t i = 0;
+
+#if defined(VSGGIS_SSE2)
+        // pixels are unpacked to 16 bit lanes, two pixels per register, with all the intermediate values kept within 0 to 65535
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i v128 = _mm_set1_epi16(128);
+        const __m128i v255 = _mm_set1_epi16(255);
+        const __m128i vOpacity = _mm_set1_epi16(static_cast<short>(opacity));
+        const __m128i alphaLanes = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+        const __m128i alphaBytes = _mm_set1_epi32(static_cast<int>(0xff000000u));
+
+        auto div255_epi16 = [&](__m128i x) {
+            x = _mm_add_epi16(x, v128);
+            return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+        };
+
+        auto blend = [&](__m128i d, __m128i s) {
+            __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+            a = div255_epi16(_mm_mullo_epi16(a, vOpacity));
+
+            __m128i b;
+            switch (blendMode)
+            {
+            case BLEND_MULTIPLY: b = div255_epi16(_mm_mullo_epi16(s, d)); break;
+            case BLEND_SCREEN: b = _mm_sub_epi16(_mm_add_epi16(s, d), div255_epi16(_mm_mullo_epi16(s, d))); break;
+            case BLEND_ADD: b = _mm_min_epi16(_mm_add_epi16(s, d), v255); break;
+            default: b = s; break;
+            }
+
+            // blending alpha with 255 gives the result alpha = d + a - d * a
+            b = _mm_or_si128(_mm_and_si128(alphaLanes, v255), _mm_andnot_si128(alphaLanes, b));
+            return div255_epi16(_mm_add_epi16(_mm_mullo_epi16(d, _mm_sub_epi16(v255, a)), _mm_mullo_epi16(b, a)));
+        };
+
+        for (; i + 4 <= numPixels; i += 4)
+        {
+            __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+
+            // overlays are often mostly transparent, so skip runs of fully transparent pixels
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(s, alphaBytes), zero)) == 0xffff) continue;
+
+            __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dest + i * 4));
+            __m128i lo = blend(_mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi8(s, zero));
+            __m128i hi = blend(_mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi8(s, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i * 4), _mm_packus_epi16(lo, hi));
+        }
+#endif
+
+        for (; i < numPixels; ++i)
+        {
+            uint8_t* d = dest + i * 4;
+            const uint8_t* s = src + i * 4;
+
+            uint32_t a = div255(s[3] * opacity);
+            if (a == 0) continue;
+
+            for (int c = 0; c < 3; ++c)
+            {
+                uint32_t b = blendComponent(d[c], s[c], blendMode);
+                d[c] = static_cast<uint8_t>(div255(d[c] * (255 - a) + b * a));
+            }
+            d[3] = static_cast<uint8_t>(div255(d[3] * (255 - a) + 255 * a));
+        }
+    }
+
+    // copy a pixel of any supported format to a 4 component pixel in the channel order of destFormat
+    inline void convertPixel(uint8_t* dest, const uint8_t* src, const PixelFormat& srcFormat, const PixelFormat& destFormat)
+    {
+        bool swap = srcFormat.bgr != destFormat.bgr;
+        dest[0] = src[swap ? 2 : 0];
+        dest[1] = src[1];
+        dest[2] = src[swap ? 0 : 2];
+        dest[3] = srcFormat.numComponents == 4 ? src[3] : 255;
+    }
+} // namespace
+
+vsg::ref_ptr<vsg::Data> vsgGIS::createCompositeImage(const vsg::Data& image)
+{
+    PixelFormat format;
+    if (!pixelFormat(image.getLayout().format, format) || !image.dataPointer()) return {};
+
+    vsg::Data::Layout layout;
+    layout.format = format.compositeFormat;
+    layout.origin = image.getLayout().origin;
+
+    uint32_t width = image.width();
+    uint32_t height = image.height();
+    auto composite = vsg::ubvec4Array2D::create(width, height, layout);
+
+    PixelFormat compositeFormat{4, format.bgr, format.compositeFormat};
+    size_t stride = pixelStride(image);
+    const uint8_t* src = static_cast<const uint8_t*>(image.dataPointer());
+    uint8_t* dest = reinterpret_cast<uint8_t*>(composite->dataPointer());
+    size_t numPixels = static_cast<size_t>(width) * height;
+
+    if (format.numComponents == 4 && stride == 4)
+    {
+        std::memcpy(dest, src, numPixels * 4);
+    }
+    else
+    {
+        for (size_t i = 0; i < numPixels; ++i) convertPixel(dest + i * 4, src + i * stride, format, compositeFormat);
+    }
+
+    return composite;
+}
+
+bool vsgGIS::compositeImage(vsg::Data& destination, const vsg::Data& source, float opacity, BlendMode blendMode)
+{
+    PixelFormat destFormat, srcFormat;
+    if (!pixelFormat(destination.getLayout().format, destFormat) || destFormat.numComponents != 4 || pixelStride(destination) != 4) return false;
+    if (!pixelFormat(source.getLayout().format, srcFormat)) return false;
+
+    uint8_t* dest = static_cast<uint8_t*>(destination.dataPointer());
+    const uint8_t* src = static_cast<const uint8_t*>(source.dataPointer());
+    if (!dest || !src) return false;
+
+    uint32_t opacity255 = static_cast<uint32_t>(std::min(1.0f, std::max(0.0f, opacity)) * 255.0f + 0.5f);
+    if (opacity255 == 0) return true;
+
+    uint32_t destWidth = destination.width(), destHeight = destination.height();
+    uint32_t srcWidth = source.width(), srcHeight = source.height();
+    if (destWidth == 0 || destHeight == 0 || srcWidth == 0 || srcHeight == 0) return true;
+
+    size_t srcStride = pixelStride(source);
+    bool flip = source.getLayout().origin != destination.getLayout().origin;
+
+    // rows that can't be blended directly from the source are gathered into row first
+    bool direct = srcFormat.numComponents == 4 && srcFormat.bgr == destFormat.bgr && srcStride == 4 && srcWidth == destWidth;
+    std::vector<uint8_t> row(direct ? 0 : destWidth * 4);
+
+    for (uint32_t y = 0; y < destHeight; ++y)
+    {
+        uint32_t srcY = static_cast<uint32_t>((static_cast<uint64_t>(y) * srcHeight) / destHeight);
+        if (flip) srcY = srcHeight - 1 - srcY;
+
+        const uint8_t* srcRow = src + static_cast<size_t>(srcY) * srcWidth * srcStride;
+        if (!direct)
+        {
+            for (uint32_t x = 0; x < destWidth; ++x)
+            {
+                uint32_t srcX = static_cast<uint32_t>((static_cast<uint64_t>(x) * srcWidth) / destWidth);
+                convertPixel(row.data() + x * 4, srcRow + srcX * srcStride, srcFormat, destFormat);
+            }
+            srcRow = row.data();
+        }
+
+        blend_row(dest + static_cast<size_t>(y) * destWidth * 4, srcRow, destWidth, opacity255, blendMode);
+    }
+
+    return true;
+}